@@ -0,0 +1,181 @@
+#pragma once
+
+#include "EHFile.h"
+
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace EH
+{
+    namespace File
+    {
+        // In-process cache of whole files.
+        //
+        // entries are keyed by path and validated against the file's mtime and size
+        // on every Get(), so a file replaced on disk is reloaded.
+        // a hit returns the same refcounted MappedFile : no copy, no I/O.
+        //
+        // the buffers are long lived MAP_PRIVATE mappings of the file. assets must be
+        // replaced by writing a new file and renaming it over the old one, never
+        // rewritten in place : a file truncated under a mapping raises SIGBUS on
+        // access, and pages of a rewritten one may show old or new contents.
+        //
+        // when the cached bytes exceed the budget the least recently used entries are
+        // dropped; buffers still held by callers stay alive until released.
+        //
+        //  AssetCache cache( 64 << 20 );
+        //  auto src = cache.Get( "shader.glsl" );
+        //  if( src ){ Compile( src->data() , src->size() ); }
+        class AssetCache
+        {
+        public:
+            using buffer_type = std::shared_ptr< const MappedFile >;
+
+            struct statistics_type
+            {
+                std::size_t hits;
+                std::size_t misses;
+                // entries reloaded because the file changed on disk
+                std::size_t stale;
+                std::size_t evictions;
+                std::size_t entries;
+                std::size_t bytes;
+            };
+
+            explicit AssetCache( std::size_t budget = std::size_t( 256 ) << 20 ) :
+                budget( budget ) ,
+                bytes( 0 ) ,
+                hits( 0 ) , misses( 0 ) , stale( 0 ) , evictions( 0 )
+            {
+            }
+            AssetCache( const AssetCache& ) = delete;
+            AssetCache& operator = ( const AssetCache& ) = delete;
+
+            // null if the file can not be read
+            buffer_type Get( const std::string& path , Access access = Access::Normal )
+            {
+                struct stat st;
+                if( stat( path.c_str() , &st ) != 0 )
+                {
+                    Invalidate( path );
+                    return buffer_type();
+                }
+                {
+                    std::lock_guard< std::mutex > lock( mutex );
+                    auto found = index.find( path );
+                    if( found != index.end() )
+                    {
+                        entry_type& e = *found->second;
+                        if( e.mtime == Mtime( st ) && e.size == static_cast< std::size_t >( st.st_size ) )
+                        {
+                            ++hits;
+                            lru.splice( lru.begin() , lru , found->second );
+                            return e.buffer;
+                        }
+                        ++stale;
+                        Erase( found );
+                    }
+                    ++misses;
+                }
+
+                // load without the lock , two threads missing the same path both read it
+                // and the later insert wins
+                MappedFile file = MapFile( path.c_str() , access );
+                if( !file ){ return buffer_type(); }
+                buffer_type buffer = std::make_shared< const MappedFile >( std::move( file ) );
+
+                std::lock_guard< std::mutex > lock( mutex );
+                auto found = index.find( path );
+                if( found != index.end() ){ Erase( found ); }
+                lru.push_front( entry_type{ path , Mtime( st ) , buffer->size() , buffer } );
+                index.emplace( path , lru.begin() );
+                bytes += buffer->size();
+                Trim();
+                return buffer;
+            }
+
+            // forget @path , the next Get() reloads it
+            void Invalidate( const std::string& path )
+            {
+                std::lock_guard< std::mutex > lock( mutex );
+                auto found = index.find( path );
+                if( found != index.end() ){ Erase( found ); }
+            }
+            void Clear()
+            {
+                std::lock_guard< std::mutex > lock( mutex );
+                index.clear();
+                lru.clear();
+                bytes = 0;
+            }
+
+            void SetBudget( std::size_t b )
+            {
+                std::lock_guard< std::mutex > lock( mutex );
+                budget = b;
+                Trim();
+            }
+            std::size_t Budget() const
+            {
+                std::lock_guard< std::mutex > lock( mutex );
+                return budget;
+            }
+
+            statistics_type Statistics() const
+            {
+                std::lock_guard< std::mutex > lock( mutex );
+                return statistics_type{ hits , misses , stale , evictions , lru.size() , bytes };
+            }
+            void ResetStatistics()
+            {
+                std::lock_guard< std::mutex > lock( mutex );
+                hits = misses = stale = evictions = 0;
+            }
+
+        protected:
+            struct entry_type
+            {
+                std::string path;
+                long long mtime;
+                std::size_t size;
+                buffer_type buffer;
+            };
+            using lru_type = std::list< entry_type >;
+            using index_type = std::unordered_map< std::string , lru_type::iterator >;
+
+            std::size_t budget;
+            std::size_t bytes;
+            std::size_t hits , misses , stale , evictions;
+
+            // most recently used first
+            lru_type lru;
+            index_type index;
+            mutable std::mutex mutex;
+
+            static long long Mtime( const struct stat& st )
+            {
+                return static_cast< long long >( st.st_mtim.tv_sec ) * 1000000000LL + st.st_mtim.tv_nsec;
+            }
+
+            void Erase( index_type::iterator found )
+            {
+                bytes -= found->second->size;
+                lru.erase( found->second );
+                index.erase( found );
+            }
+            // the newest entry is kept even if it alone exceeds the budget
+            void Trim()
+            {
+                while( bytes > budget && lru.size() > 1 )
+                {
+                    ++evictions;
+                    Erase( index.find( lru.back().path ) );
+                }
+            }
+        };
+    };  // namespace File
+};  // namespace EH
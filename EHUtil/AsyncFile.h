@@ -0,0 +1,237 @@
+#pragma once
+
+#include "EHFile.h"
+#include "ThreadPool.h"
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <queue>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <functional>
+
+namespace EH
+{
+    namespace File
+    {
+        // Loads files on a pool of I/O threads.
+        //
+        // requests wait in a priority queue ( higher first , FIFO among equals ),
+        // each I/O thread takes the best one when it becomes free.
+        // files are mapped with Access::WillNeed, so the pages are faulted in on the
+        // I/O thread and the consumer gets resident memory.
+        // at most @max_inflight bytes are being read at once; a single file larger
+        // than that is still read, alone.
+        //
+        //  AsyncLoader loader;
+        //  auto shader = loader.Load( "shader.glsl" , 10 );
+        //  ...
+        //  MappedFile file = shader.get();
+        class AsyncLoader
+        {
+        public:
+            using callback_type = std::function< void( const std::string& , MappedFile&& ) >;
+
+        protected:
+            enum : int
+            {
+                queued , running , done , cancelled
+            };
+            struct request_type
+            {
+                std::string path;
+                int priority;
+                std::size_t sequence;
+                std::atomic< int > state;
+                std::promise< MappedFile > promise;
+                callback_type callback;
+            };
+            using request_ptr = std::shared_ptr< request_type >;
+
+        public:
+            // result of Load() ; a future plus the ability to cancel while queued
+            class Handle
+            {
+            public:
+                Handle()
+                {
+                }
+
+                // blocks until the file is loaded.
+                // failed or cancelled loads give an empty MappedFile
+                // ( requests with a callback deliver there instead )
+                MappedFile get()
+                {
+                    return future.get();
+                }
+                bool ready() const
+                {
+                    return future.wait_for( std::chrono::seconds( 0 ) ) == std::future_status::ready;
+                }
+                void wait() const
+                {
+                    future.wait();
+                }
+                // true if the request had not started yet and will not run
+                bool Cancel()
+                {
+                    int expected = queued;
+                    return request && request->state.compare_exchange_strong( expected , cancelled );
+                }
+
+            protected:
+                friend class AsyncLoader;
+
+                request_ptr request;
+                std::future< MappedFile > future;
+            };
+
+            // at least one I/O thread , a pool without workers would never run a load
+            AsyncLoader( std::size_t io_threads = 4 , std::size_t max_inflight = std::size_t( 256 ) << 20 ) :
+                max_inflight( max_inflight ) ,
+                inflight( 0 ) ,
+                sequence( 0 ) ,
+                pool( std::max< std::size_t >( io_threads , 1 ) )
+            {
+            }
+            ~AsyncLoader()
+            {
+                // drop what has not started , then let ~ThreadPool drain the pumps
+                std::vector< request_ptr > dropped;
+                {
+                    std::lock_guard< std::mutex > lock( mutex );
+                    while( queue.empty() == false )
+                    {
+                        dropped.push_back( queue.top() );
+                        queue.pop();
+                    }
+                }
+                for( auto& r : dropped )
+                {
+                    r->state = cancelled;
+                    Finish( r , MappedFile() );
+                }
+            }
+
+            Handle Load( std::string path , int priority = 0 )
+            {
+                return Submit( std::move( path ) , priority , callback_type() );
+            }
+            // @done runs on an I/O thread
+            Handle Load( std::string path , callback_type done , int priority = 0 )
+            {
+                return Submit( std::move( path ) , priority , std::move( done ) );
+            }
+            std::vector< Handle > Load( const std::vector< std::string >& paths , int priority = 0 )
+            {
+                std::vector< Handle > ret;
+                ret.reserve( paths.size() );
+                for( const auto& p : paths )
+                {
+                    ret.push_back( Submit( p , priority , callback_type() ) );
+                }
+                return ret;
+            }
+
+            std::size_t InflightBytes() const
+            {
+                std::lock_guard< std::mutex > lock( mutex );
+                return inflight;
+            }
+
+        protected:
+            struct request_order
+            {
+                bool operator () ( const request_ptr& a , const request_ptr& b ) const
+                {
+                    if( a->priority != b->priority ){ return a->priority < b->priority; }
+                    return a->sequence > b->sequence;
+                }
+            };
+
+            const std::size_t max_inflight;
+            std::size_t inflight;
+            std::size_t sequence;
+
+            mutable std::mutex mutex;
+            std::condition_variable budget_cv;
+            std::priority_queue< request_ptr , std::vector< request_ptr > , request_order > queue;
+
+            // last : joined first on destruction
+            ThreadPool pool;
+
+            Handle Submit( std::string path , int priority , callback_type callback )
+            {
+                request_ptr r = std::make_shared< request_type >();
+                r->path = std::move( path );
+                r->priority = priority;
+                r->state = queued;
+                r->callback = std::move( callback );
+
+                Handle h;
+                h.request = r;
+                h.future  = r->promise.get_future();
+                {
+                    std::lock_guard< std::mutex > lock( mutex );
+                    r->sequence = sequence++;
+                    queue.push( std::move( r ) );
+                }
+                // one pump per request , it serves whatever is best when it runs
+                pool.Push( [ this ](){ Pump(); } );
+                return h;
+            }
+
+            void Pump()
+            {
+                request_ptr r;
+                {
+                    std::lock_guard< std::mutex > lock( mutex );
+                    if( queue.empty() ){ return; }
+                    r = queue.top();
+                    queue.pop();
+                }
+                int expected = queued;
+                if( r->state.compare_exchange_strong( expected , running ) == false )
+                {
+                    Finish( r , MappedFile() );
+                    return;
+                }
+
+                struct stat st;
+                const std::size_t bytes = stat( r->path.c_str() , &st ) == 0 && st.st_size > 0 ? static_cast< std::size_t >( st.st_size ) : 0;
+                {
+                    std::unique_lock< std::mutex > lock( mutex );
+                    budget_cv.wait( lock , [ this , bytes ](){ return inflight == 0 || inflight + bytes <= max_inflight; } );
+                    inflight += bytes;
+                }
+
+                MappedFile file = MapFile( r->path.c_str() , Access::WillNeed );
+
+                {
+                    std::lock_guard< std::mutex > lock( mutex );
+                    inflight -= bytes;
+                }
+                budget_cv.notify_all();
+
+                r->state = done;
+                Finish( r , std::move( file ) );
+            }
+
+            void Finish( const request_ptr& r , MappedFile&& file )
+            {
+                if( r->callback )
+                {
+                    r->callback( r->path , std::move( file ) );
+                    r->promise.set_value( MappedFile() );
+                }else
+                {
+                    r->promise.set_value( std::move( file ) );
+                }
+            }
+        };
+    };  // namespace File
+};  // namespace EH
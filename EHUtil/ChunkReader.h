@@ -0,0 +1,213 @@
+#pragma once
+
+#include "EHFile.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdlib>
+
+namespace EH
+{
+    namespace File
+    {
+        // Reads a file front to back in fixed size chunks with bounded memory.
+        //
+        // two chunk buffers are owned; a background thread fills one while the
+        // caller processes the other, so reading and processing overlap.
+        // a chunk returned by Next() stays valid until the following Next().
+        //
+        //  ChunkReader reader( "huge.log" );
+        //  for( auto chunk = reader.Next(); chunk.size; chunk = reader.Next() )
+        //  {
+        //      parser.feed( chunk.data , chunk.data + chunk.size );
+        //  }
+        class ChunkReader
+        {
+        public:
+            struct chunk_type
+            {
+                const char *data;
+                std::size_t size;
+            };
+
+            // @chunk_size is the size of every chunk but the last
+            explicit ChunkReader( const char *name , std::size_t chunk_size = std::size_t( 1 ) << 20 ) :
+                fd( -1 ) ,
+                chunk_size( chunk_size > 0 ? chunk_size : 1 ) ,
+                offset( 0 ) ,
+                current( -1 ) ,
+                next( 0 ) ,
+                finished( false ) ,
+                failed( false ) ,
+                stop( false )
+            {
+                buffers[ 0 ].data = buffers[ 1 ].data = 0;
+                fd = open( name , O_RDONLY | O_CLOEXEC );
+                if( fd < 0 )
+                {
+                    ERROR( "File Chunk : can not open " , name , " : " , std::strerror( errno ) );
+                    failed = true;
+                    finished = true;
+                    return;
+                }
+                for( auto& b : buffers )
+                {
+                    if( posix_memalign( reinterpret_cast< void** >( &b.data ) , 64 , this->chunk_size ) )
+                    {
+                        b.data = 0;
+                        ERROR( "File Chunk : out of memory reading " , name );
+                        failed = true;
+                        finished = true;
+                        return;
+                    }
+                    b.size = 0;
+                    b.filled = false;
+                }
+#ifdef POSIX_FADV_SEQUENTIAL
+                posix_fadvise( fd , 0 , 0 , POSIX_FADV_SEQUENTIAL );
+#endif
+                thread = std::thread( [ this ](){ ReadLoop(); } );
+            }
+            ~ChunkReader()
+            {
+                {
+                    std::lock_guard< std::mutex > lock( mutex );
+                    stop = true;
+                }
+                cv.notify_all();
+                if( thread.joinable() ){ thread.join(); }
+                if( fd >= 0 ){ close( fd ); }
+                std::free( buffers[ 0 ].data );
+                std::free( buffers[ 1 ].data );
+            }
+            ChunkReader( const ChunkReader& ) = delete;
+            ChunkReader& operator = ( const ChunkReader& ) = delete;
+
+            // the next chunk , size 0 at the end of the file or after an error
+            chunk_type Next()
+            {
+                std::unique_lock< std::mutex > lock( mutex );
+                // hand the chunk the caller is done with back to the reader
+                if( current >= 0 )
+                {
+                    buffers[ current ].filled = false;
+                    current = -1;
+                    cv.notify_all();
+                }
+                if( finished ){ return chunk_type{ 0 , 0 }; }
+
+                cv.wait( lock , [ this ](){ return buffers[ next ].filled; } );
+                buffer_type& b = buffers[ next ];
+                if( b.size == 0 )
+                {
+                    // end of file ( or read error ) marker
+                    b.filled = false;
+                    finished = true;
+                    return chunk_type{ 0 , 0 };
+                }
+                current = next;
+                next ^= 1;
+                offset += b.size;
+                return chunk_type{ b.data , b.size };
+            }
+
+            // calls f( data , size ) for every chunk , returns the bytes consumed
+            template < typename F >
+            std::size_t ForEach( F&& f )
+            {
+                std::size_t total = 0;
+                for( chunk_type c = Next(); c.size; c = Next() )
+                {
+                    f( c.data , c.size );
+                    total += c.size;
+                }
+                return total;
+            }
+
+            // file offset just past the last chunk returned
+            std::size_t Offset() const
+            {
+                return offset;
+            }
+            std::size_t ChunkSize() const
+            {
+                return chunk_size;
+            }
+            // false if the file could not be opened or a read failed
+            explicit operator bool () const
+            {
+                std::lock_guard< std::mutex > lock( mutex );
+                return failed == false;
+            }
+
+        protected:
+            struct buffer_type
+            {
+                char *data;
+                std::size_t size;
+                bool filled;
+            };
+
+            int fd;
+            const std::size_t chunk_size;
+            std::size_t offset;
+
+            buffer_type buffers[ 2 ];
+            // buffer held by the caller , -1 if none
+            int current;
+            // buffer the caller takes next
+            int next;
+            bool finished;
+            bool failed;
+            bool stop;
+
+            mutable std::mutex mutex;
+            std::condition_variable cv;
+            std::thread thread;
+
+            // fills the buffers alternately , a buffer of size 0 marks the end
+            void ReadLoop()
+            {
+                int w = 0;
+                while( true )
+                {
+                    {
+                        std::unique_lock< std::mutex > lock( mutex );
+                        cv.wait( lock , [ this , w ](){ return stop || buffers[ w ].filled == false; } );
+                        if( stop ){ return; }
+                    }
+
+                    // the buffer is ours until it is marked filled
+                    buffer_type& b = buffers[ w ];
+                    std::size_t sz = 0;
+                    bool error = false;
+                    while( sz < chunk_size )
+                    {
+                        const ssize_t r = read( fd , b.data + sz , chunk_size - sz );
+                        if( r < 0 )
+                        {
+                            if( errno == EINTR ){ continue; }
+                            ERROR( "File Chunk : read failed : " , std::strerror( errno ) );
+                            error = true;
+                            break;
+                        }
+                        if( r == 0 ){ break; }
+                        sz += static_cast< std::size_t >( r );
+                    }
+
+                    {
+                        std::lock_guard< std::mutex > lock( mutex );
+                        b.size = error ? 0 : sz;
+                        b.filled = true;
+                        if( error ){ failed = true; }
+                    }
+                    cv.notify_all();
+                    if( error || sz == 0 ){ return; }
+                    // a short chunk is the last one, still deliver the end marker
+                    w ^= 1;
+                }
+            }
+        };
+    };  // namespace File
+};  // namespace EH
@@ -2,23 +2,47 @@
 
 #include "../EHLog.h"
 #include "Memory.h"
+#include "LZ.h"
 #include <memory>
+#include <new>
 #include <utility>
 #include <fstream>
+#include <cstdlib>
+#include <cerrno>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace EH
 {
     namespace File
     {
+        // returns null pointer and size 0 if the file can not be read
         template < typename RET = char , typename SizeType >
         auto LoadFile( const char *name , std::ios_base::openmode mode , SizeType&& size )
         {
             using remove_ref = typename std::remove_reference< SizeType >::type;
             using remove_con = typename std::remove_const< remove_ref >::type;
+            using ptr_type = Ptr< RET , std::default_delete< RET[] > >;
             std::ifstream fbuf( name , mode );
 
+            size = 0;
+            if( !fbuf )
+            {
+                ERROR( "File Load : can not open " , name );
+                return ptr_type();
+            }
+
             fbuf.seekg( 0 , std::ios_base::end );
             const long sz = fbuf.tellg();
+            if( sz < 0 )
+            {
+                ERROR( "File Load : can not seek " , name );
+                return ptr_type();
+            }
             LOG( "File Load Text : \n" , name , "\n" , sz , " bytes\n" );
             fbuf.seekg( 0 , std::ios_base::beg );
 
@@ -29,7 +53,7 @@ namespace EH
             fbuf.read( ptr , sz );
             fbuf.close();
 
-            return Ptr< RET , std::default_delete< RET[] > >( reinterpret_cast< RET* >( ptr ) );
+            return ptr_type( reinterpret_cast< RET* >( ptr ) );
         }
 
 
@@ -38,10 +62,254 @@ namespace EH
         {
             return LoadFile< RET >( name , std::ios_base::in , std::forward< SizeType >( size ) );
         }
+        // "EHLZ" containers ( see LZ.h ) are decoded transparently, in parallel,
+        // and @size is the decoded size. a container with a malformed header fails
+        // ( null pointer , size 0 ) , other files are returned as they are
         template < typename RET = char , typename SizeType >
         auto LoadBinary( const char *name , SizeType&& size )
         {
-            return LoadFile< RET >( name , std::ios_base::in | std::ios_base::binary , std::forward< SizeType >( size ) );
+            using remove_ref = typename std::remove_reference< SizeType >::type;
+            using remove_con = typename std::remove_const< remove_ref >::type;
+            using ptr_type = Ptr< RET , std::default_delete< RET[] > >;
+
+            std::size_t sz;
+            auto file = LoadFile< char >( name , std::ios_base::in | std::ios_base::binary , sz );
+            if( file.data() == 0 || LZ::IsContainer( file.data() , sz ) == false )
+            {
+                size = static_cast< remove_con >( sz );
+                return ptr_type( reinterpret_cast< RET* >( file.set_zero() ) );
+            }
+
+            if( LZ::IsValidHeader( file.data() , sz ) == false )
+            {
+                size = 0;
+                ERROR( "File Load : corrupted compressed file header " , name );
+                return ptr_type();
+            }
+            const std::uint64_t raw = LZ::RawSize( file.data() );
+            char *ptr = new ( std::nothrow ) char[ raw + 1 ];
+            if( ptr == 0 )
+            {
+                size = 0;
+                ERROR( "File Load : out of memory decoding " , name );
+                return ptr_type();
+            }
+            ptr[ raw ] = 0;
+            if( LZ::Decompress( file.data() , sz , ptr ) == false )
+            {
+                delete[] ptr;
+                size = 0;
+                ERROR( "File Load : corrupted compressed file " , name );
+                return ptr_type();
+            }
+            LOG( "File Load Compressed : \n" , name , "\n" , sz , " -> " , raw , " bytes\n" );
+            size = static_cast< remove_con >( raw );
+            return ptr_type( reinterpret_cast< RET* >( ptr ) );
+        }
+
+        // access pattern hint for MapFile, forwarded to madvise
+        enum class Access
+        {
+            Normal ,
+            Sequential ,
+            Random ,
+            // fault every page in up front ( MAP_POPULATE )
+            WillNeed
+        };
+
+        // read-only view of a whole file.
+        // regular files are mmap'ed, so the view shares the page cache and nothing is copied;
+        // pipes and other unsized files are read into an aligned buffer instead.
+        // the view is NOT null terminated.
+        class MappedFile
+        {
+        public:
+            MappedFile() :
+                ptr( 0 ) , sz( 0 ) , mapped( false )
+            {
+            }
+            MappedFile( MappedFile&& rhs ) :
+                ptr( rhs.ptr ) , sz( rhs.sz ) , mapped( rhs.mapped )
+            {
+                rhs.ptr = 0;
+                rhs.sz  = 0;
+                rhs.mapped = false;
+            }
+            MappedFile& operator = ( MappedFile&& rhs )
+            {
+                release();
+                ptr = rhs.ptr;
+                sz  = rhs.sz;
+                mapped = rhs.mapped;
+                rhs.ptr = 0;
+                rhs.sz  = 0;
+                rhs.mapped = false;
+
+                return *this;
+            }
+            MappedFile( const MappedFile& ) = delete;
+            MappedFile& operator = ( const MappedFile& ) = delete;
+            ~MappedFile()
+            {
+                release();
+            }
+
+            const char* data() const
+            {
+                return ptr;
+            }
+            std::size_t size() const
+            {
+                return sz;
+            }
+            const char* begin() const
+            {
+                return ptr;
+            }
+            const char* end() const
+            {
+                return ptr + sz;
+            }
+            // true if the file was opened ( an empty file is valid )
+            explicit operator bool () const
+            {
+                return ptr != 0;
+            }
+            bool is_mapped() const
+            {
+                return mapped;
+            }
+
+            // change the access hint of an already mapped file
+            void Advise( Access access ) const
+            {
+                if( mapped && sz )
+                {
+                    madvise( const_cast< char* >( ptr ) , sz , advice( access ) );
+                }
+            }
+
+            static int advice( Access access )
+            {
+                switch( access )
+                {
+                case Access::Sequential:
+                    return MADV_SEQUENTIAL;
+                case Access::Random:
+                    return MADV_RANDOM;
+                case Access::WillNeed:
+                    return MADV_WILLNEED;
+                default:
+                    return MADV_NORMAL;
+                }
+            }
+
+        protected:
+            friend MappedFile MapFile( const char *name , Access access );
+
+            const char *ptr;
+            std::size_t sz;
+            bool mapped;
+
+            MappedFile( const char *p , std::size_t s , bool m ) :
+                ptr( p ) , sz( s ) , mapped( m )
+            {
+            }
+
+            void release()
+            {
+                if( ptr )
+                {
+                    if( mapped )
+                    {
+                        munmap( const_cast< char* >( ptr ) , sz );
+                    }else
+                    {
+                        std::free( const_cast< char* >( ptr ) );
+                    }
+                }
+                ptr = 0;
+                sz  = 0;
+                mapped = false;
+            }
+        };
+
+        // returns an empty MappedFile ( operator bool false ) if the file can not be read
+        inline MappedFile MapFile( const char *name , Access access = Access::Normal )
+        {
+            const int fd = open( name , O_RDONLY | O_CLOEXEC );
+            if( fd < 0 )
+            {
+                ERROR( "File Map : can not open " , name , " : " , std::strerror( errno ) );
+                return MappedFile();
+            }
+            struct stat st;
+            if( fstat( fd , &st ) != 0 )
+            {
+                ERROR( "File Map : can not stat " , name , " : " , std::strerror( errno ) );
+                close( fd );
+                return MappedFile();
+            }
+
+            if( S_ISREG( st.st_mode ) && st.st_size > 0 )
+            {
+                const std::size_t sz = static_cast< std::size_t >( st.st_size );
+                const int flags = MAP_PRIVATE | ( access == Access::WillNeed ? MAP_POPULATE : 0 );
+                void *addr = mmap( 0 , sz , PROT_READ , flags , fd , 0 );
+                if( addr != MAP_FAILED )
+                {
+                    close( fd );
+                    madvise( addr , sz , MappedFile::advice( access ) );
+                    LOG( "File Map : \n" , name , "\n" , sz , " bytes\n" );
+                    return MappedFile( reinterpret_cast< const char* >( addr ) , sz , true );
+                }
+                // fall through to read() , e.g. filesystems without mmap support
+            }
+
+            // read() into a 64 byte aligned buffer; one call when the size is known
+            // ( one spare byte so the read that sees EOF does not grow the buffer ),
+            // doubling the buffer for pipes and unsized files ( /proc reports size 0 )
+            std::size_t capacity = S_ISREG( st.st_mode ) && st.st_size > 0 ? static_cast< std::size_t >( st.st_size ) + 1 : 1 << 16;
+            std::size_t sz = 0;
+            char *buf = 0;
+            if( posix_memalign( reinterpret_cast< void** >( &buf ) , 64 , capacity ) )
+            {
+                close( fd );
+                ERROR( "File Map : out of memory reading " , name );
+                return MappedFile();
+            }
+            while( true )
+            {
+                if( sz == capacity )
+                {
+                    char *grown = 0;
+                    if( posix_memalign( reinterpret_cast< void** >( &grown ) , 64 , capacity * 2 ) )
+                    {
+                        std::free( buf );
+                        close( fd );
+                        ERROR( "File Map : out of memory reading " , name );
+                        return MappedFile();
+                    }
+                    std::memcpy( grown , buf , sz );
+                    std::free( buf );
+                    buf = grown;
+                    capacity *= 2;
+                }
+                const ssize_t r = read( fd , buf + sz , capacity - sz );
+                if( r < 0 )
+                {
+                    if( errno == EINTR ){ continue; }
+                    ERROR( "File Map : read failed " , name , " : " , std::strerror( errno ) );
+                    std::free( buf );
+                    close( fd );
+                    return MappedFile();
+                }
+                if( r == 0 ){ break; }
+                sz += static_cast< std::size_t >( r );
+            }
+            close( fd );
+            LOG( "File Read : \n" , name , "\n" , sz , " bytes\n" );
+            return MappedFile( buf , sz , false );
         }
     };  // namespace File
 };  // namespace EH
@@ -0,0 +1,322 @@
+#pragma once
+
+#include "EHFile.h"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+
+#include <sys/uio.h>
+
+namespace EH
+{
+    namespace File
+    {
+        // Appends to a file from any thread; the actual I/O happens on a background thread.
+        //
+        // Write() copies into the current buffer and returns. a full buffer is handed
+        // to the writer thread, which writes every pending buffer with one writev().
+        // fsync is batched : data is synced at most @sync_ms after it was written,
+        // so many writes share one fdatasync.
+        // Write() blocks only when every buffer is waiting for the disk.
+        //
+        //  Writer log( "frame.log" );
+        //  log.Write( line );
+        //  ...
+        //  log.Sync();     // durable up to here
+        class Writer
+        {
+        public:
+            struct options_type
+            {
+                std::size_t buffer_size = std::size_t( 1 ) << 20;
+                std::size_t buffers = 4;
+                // < 0 : only on Sync() , 0 : after every batch
+                int sync_ms = 1000;
+                // append to an existing file instead of truncating it
+                bool append = false;
+            };
+
+            explicit Writer( const char *name ) :
+                Writer( name , options_type() )
+            {
+            }
+            Writer( const char *name , options_type options ) :
+                options( options ) ,
+                fd( -1 ) ,
+                active( 0 ) ,
+                accepted( 0 ) ,
+                submitted( 0 ) ,
+                completed( 0 ) ,
+                sync_wanted( 0 ) ,
+                synced( 0 ) ,
+                dirty( false ) ,
+                blocked( false ) ,
+                failed( false ) ,
+                stop( false )
+            {
+                this->options.buffer_size = std::max< std::size_t >( this->options.buffer_size , 1 );
+                this->options.buffers = std::max< std::size_t >( this->options.buffers , 2 );
+                fd = open( name , O_WRONLY | O_CREAT | O_CLOEXEC | ( options.append ? O_APPEND : O_TRUNC ) , 0644 );
+                if( fd < 0 )
+                {
+                    ERROR( "File Write : can not open " , name , " : " , std::strerror( errno ) );
+                    failed = true;
+                    return;
+                }
+                buffers.resize( this->options.buffers );
+                for( std::size_t i = 0; i < buffers.size(); ++i )
+                {
+                    if( posix_memalign( reinterpret_cast< void** >( &buffers[ i ].data ) , 64 , this->options.buffer_size ) )
+                    {
+                        buffers[ i ].data = 0;
+                        ERROR( "File Write : out of memory for " , name );
+                        failed = true;
+                        return;
+                    }
+                    if( i ){ free_buffers.push_back( i ); }
+                }
+                thread = std::thread( [ this ](){ WriteLoop(); } );
+            }
+            ~Writer()
+            {
+                if( thread.joinable() )
+                {
+                    if( options.sync_ms >= 0 ){ Sync(); }else{ Flush(); }
+                    {
+                        std::lock_guard< std::mutex > lock( mutex );
+                        stop = true;
+                    }
+                    cv.notify_all();
+                    thread.join();
+                }
+                if( fd >= 0 ){ close( fd ); }
+                for( auto& b : buffers ){ std::free( b.data ); }
+            }
+            Writer( const Writer& ) = delete;
+            Writer& operator = ( const Writer& ) = delete;
+
+            // false if the file could not be opened or a write failed
+            explicit operator bool () const
+            {
+                std::lock_guard< std::mutex > lock( mutex );
+                return failed == false;
+            }
+
+            void Write( const void *data , std::size_t size )
+            {
+                const char *p = static_cast< const char* >( data );
+                std::unique_lock< std::mutex > lock( mutex );
+                if( thread.joinable() == false ){ return; }
+                Enter( lock );
+                accepted += size;
+                while( size )
+                {
+                    buffer_type& b = buffers[ active ];
+                    const std::size_t n = std::min( size , options.buffer_size - b.size );
+                    std::memcpy( b.data + b.size , p , n );
+                    b.size += n;
+                    p += n;
+                    size -= n;
+                    if( b.size == options.buffer_size ){ Submit( lock ); }
+                }
+            }
+            void Write( const std::string& s )
+            {
+                Write( s.data() , s.size() );
+            }
+
+            // returns once everything written so far reached the kernel
+            void Flush()
+            {
+                std::unique_lock< std::mutex > lock( mutex );
+                if( thread.joinable() == false ){ return; }
+                Enter( lock );
+                if( buffers[ active ].size ){ Submit( lock ); }
+                const std::size_t target = submitted;
+                cv.wait( lock , [ this , target ](){ return completed >= target; } );
+            }
+            // returns once everything written so far is on the disk
+            void Sync()
+            {
+                std::unique_lock< std::mutex > lock( mutex );
+                if( thread.joinable() == false ){ return; }
+                Enter( lock );
+                if( buffers[ active ].size ){ Submit( lock ); }
+                const std::size_t target = submitted;
+                sync_wanted = std::max( sync_wanted , target );
+                cv.notify_all();
+                cv.wait( lock , [ this , target ](){ return synced >= target; } );
+            }
+
+            // bytes passed to Write()
+            std::size_t Size() const
+            {
+                std::lock_guard< std::mutex > lock( mutex );
+                return accepted;
+            }
+
+        protected:
+            using clock_type = std::chrono::steady_clock;
+
+            struct buffer_type
+            {
+                char *data = 0;
+                std::size_t size = 0;
+            };
+
+            options_type options;
+            int fd;
+
+            std::vector< buffer_type > buffers;
+            // buffer Write() copies into
+            std::size_t active;
+            std::deque< std::size_t > filled;
+            std::vector< std::size_t > free_buffers;
+
+            // byte counters : passed to Write() , handed to the thread , written , synced
+            std::size_t accepted;
+            std::size_t submitted;
+            std::size_t completed;
+            std::size_t sync_wanted;
+            std::size_t synced;
+            // written but not synced since
+            bool dirty;
+            clock_type::time_point dirty_since;
+
+            // a caller waits in Submit() for a free buffer
+            bool blocked;
+            bool failed;
+            bool stop;
+
+            mutable std::mutex mutex;
+            std::condition_variable cv;
+            std::thread thread;
+
+            // wait until no other caller is blocked in Submit(), so a Write() that
+            // spans buffers stays contiguous in the file
+            void Enter( std::unique_lock< std::mutex >& lock )
+            {
+                cv.wait( lock , [ this ](){ return blocked == false; } );
+            }
+            // queue the active buffer and take a free one , waiting if there is none
+            void Submit( std::unique_lock< std::mutex >& lock )
+            {
+                if( free_buffers.empty() )
+                {
+                    blocked = true;
+                    cv.wait( lock , [ this ](){ return free_buffers.empty() == false; } );
+                    blocked = false;
+                }
+                submitted += buffers[ active ].size;
+                filled.push_back( active );
+                active = free_buffers.back();
+                free_buffers.pop_back();
+                cv.notify_all();
+            }
+
+            void WriteLoop()
+            {
+                std::vector< std::size_t > batch;
+                std::vector< struct iovec > iov;
+                std::unique_lock< std::mutex > lock( mutex );
+                while( true )
+                {
+                    auto ready = [ this ](){ return stop || filled.empty() == false || sync_wanted > synced; };
+                    if( dirty && options.sync_ms > 0 )
+                    {
+                        cv.wait_until( lock , dirty_since + std::chrono::milliseconds( options.sync_ms ) , ready );
+                    }else if( dirty == false || options.sync_ms < 0 )
+                    {
+                        cv.wait( lock , ready );
+                    }
+
+                    if( filled.empty() == false )
+                    {
+                        batch.assign( filled.begin() , filled.end() );
+                        filled.clear();
+                        lock.unlock();
+
+                        std::size_t bytes = 0;
+                        iov.clear();
+                        for( std::size_t i : batch )
+                        {
+                            iov.push_back( iovec{ buffers[ i ].data , buffers[ i ].size } );
+                            bytes += buffers[ i ].size;
+                        }
+                        const bool ok = WriteAll( iov );
+
+                        lock.lock();
+                        for( std::size_t i : batch )
+                        {
+                            buffers[ i ].size = 0;
+                            free_buffers.push_back( i );
+                        }
+                        completed += bytes;
+                        if( ok == false ){ failed = true; }
+                        if( dirty == false )
+                        {
+                            dirty = true;
+                            dirty_since = clock_type::now();
+                        }
+                        cv.notify_all();
+                        continue;
+                    }
+
+                    const bool expired = dirty && options.sync_ms >= 0 &&
+                                         clock_type::now() >= dirty_since + std::chrono::milliseconds( options.sync_ms );
+                    if( sync_wanted > synced || expired )
+                    {
+                        const std::size_t target = completed;
+                        lock.unlock();
+                        const bool ok = fdatasync( fd ) == 0;
+                        if( ok == false ){ ERROR( "File Write : fdatasync failed : " , std::strerror( errno ) ); }
+                        lock.lock();
+                        if( ok == false ){ failed = true; }
+                        synced = std::max( synced , target );
+                        dirty = completed > synced;
+                        cv.notify_all();
+                        continue;
+                    }
+                    if( stop ){ return; }
+                }
+            }
+
+            // writev until every byte is out , retrying partial writes
+            bool WriteAll( std::vector< struct iovec >& iov )
+            {
+                std::size_t first = 0;
+                while( first < iov.size() )
+                {
+                    const int count = static_cast< int >( std::min< std::size_t >( iov.size() - first , IOV_MAX ) );
+                    const ssize_t r = writev( fd , iov.data() + first , count );
+                    if( r < 0 )
+                    {
+                        if( errno == EINTR ){ continue; }
+                        ERROR( "File Write : write failed : " , std::strerror( errno ) );
+                        return false;
+                    }
+                    std::size_t n = static_cast< std::size_t >( r );
+                    while( first < iov.size() && n >= iov[ first ].iov_len )
+                    {
+                        n -= iov[ first ].iov_len;
+                        ++first;
+                    }
+                    if( n )
+                    {
+                        iov[ first ].iov_base = static_cast< char* >( iov[ first ].iov_base ) + n;
+                        iov[ first ].iov_len -= n;
+                    }
+                }
+                return true;
+            }
+        };
+    };  // namespace File
+};  // namespace EH
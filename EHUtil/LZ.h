@@ -0,0 +1,350 @@
+#pragma once
+
+#include "ThreadPool.h"
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+#include <cstring>
+
+namespace EH
+{
+    // LZ77 block codec in the LZ4 block format, and a container of independent blocks.
+    //
+    // a block is a run of sequences :
+    //  token           high nibble literal length , low nibble match length - 4 ( 15 : continued )
+    //  literal length  255 ... , last byte < 255     ( only if the nibble was 15 )
+    //  literals
+    //  offset          2 bytes little endian , 1 .. 65535
+    //  match length    255 ... , last byte < 255     ( only if the nibble was 15 )
+    // the last sequence has literals only; the last 5 bytes are always literals and
+    // no match starts in the last 12 bytes.
+    //
+    // container ( "EHLZ" ) :
+    //  lz_header                   version format_version , flags 0
+    //  uint32_t[ block_count ]     compressed size of every block , high bit : stored as is
+    //  blocks
+    // every block but the last holds block_size raw bytes, so blocks decode in parallel
+    // straight into their slice of the output.
+    namespace LZ
+    {
+        struct lz_header
+        {
+            char magic[ 4 ];
+            std::uint32_t block_size;
+            std::uint64_t raw_size;
+            std::uint32_t block_count;
+            std::uint16_t version;
+            std::uint16_t flags;
+        };
+        static_assert( sizeof( lz_header ) == 24 , "lz_header layout" );
+
+        constexpr std::size_t min_match = 4;
+        constexpr std::size_t last_literals = 5;
+        constexpr std::size_t match_limit = 12;
+        constexpr std::size_t max_offset = 65535;
+        constexpr std::uint32_t stored_flag = 0x80000000u;
+        // lz_header::version written by Compress(); flags are 0
+        constexpr std::uint16_t format_version = 1;
+        // a sequence of n input bytes yields less than 255 * n output bytes
+        constexpr std::uint64_t max_ratio = 255;
+
+        // worst case compressed size of @n bytes
+        constexpr std::size_t Bound( std::size_t n )
+        {
+            return n + n / 255 + 16;
+        }
+
+        namespace detail
+        {
+            inline std::uint32_t Read32( const unsigned char *p )
+            {
+                std::uint32_t v;
+                std::memcpy( &v , p , 4 );
+                return v;
+            }
+            inline std::uint32_t Hash( std::uint32_t v )
+            {
+                return ( v * 2654435761u ) >> 20;
+            }
+            // 255 , 255 , ... , rest
+            inline unsigned char* WriteLength( unsigned char *op , std::size_t len )
+            {
+                for( ; len >= 255; len -= 255 ){ *op++ = 255; }
+                *op++ = static_cast< unsigned char >( len );
+                return op;
+            }
+            // one sequence , null if it does not fit before @oend
+            inline unsigned char* WriteSequence( unsigned char *op , unsigned char *oend ,
+                    const unsigned char *literals , std::size_t lit , std::size_t offset , std::size_t match )
+            {
+                const std::size_t need = 1 + ( lit >= 15 ? lit / 255 + 1 : 0 ) + lit +
+                                         ( match ? 2 + ( match - min_match >= 15 ? ( match - min_match ) / 255 + 1 : 0 ) : 0 );
+                if( need > static_cast< std::size_t >( oend - op ) ){ return 0; }
+
+                unsigned char *token = op++;
+                *token = static_cast< unsigned char >( ( lit >= 15 ? 15 : lit ) << 4 );
+                if( lit >= 15 ){ op = WriteLength( op , lit - 15 ); }
+                std::memcpy( op , literals , lit );
+                op += lit;
+                if( match )
+                {
+                    *op++ = static_cast< unsigned char >( offset );
+                    *op++ = static_cast< unsigned char >( offset >> 8 );
+                    const std::size_t m = match - min_match;
+                    *token |= static_cast< unsigned char >( m >= 15 ? 15 : m );
+                    if( m >= 15 ){ op = WriteLength( op , m - 15 ); }
+                }
+                return op;
+            }
+            // continued length , false on truncated input
+            inline bool ReadLength( const unsigned char *&ip , const unsigned char *iend , std::size_t& len )
+            {
+                unsigned char b;
+                do
+                {
+                    if( ip == iend ){ return false; }
+                    b = *ip++;
+                    len += b;
+                }while( b == 255 );
+                return true;
+            }
+        };  // namespace detail
+
+        // compresses one block , returns the compressed size or 0 if it does not fit in @capacity
+        // ( Bound( n ) always fits )
+        inline std::size_t CompressBlock( const char *source , std::size_t n , char *dest , std::size_t capacity )
+        {
+            const unsigned char *src = reinterpret_cast< const unsigned char* >( source );
+            const unsigned char *end = src + n;
+            const unsigned char *anchor = src;
+            unsigned char *op = reinterpret_cast< unsigned char* >( dest );
+            unsigned char *oend = op + capacity;
+
+            if( n > match_limit )
+            {
+                // 4096 entry table of offsets into the block
+                std::uint32_t table[ 1 << 12 ] = {};
+                const unsigned char *mlimit = end - match_limit;
+                const unsigned char *matchlimit = end - last_literals;
+                const unsigned char *ip = src + 1;
+                std::size_t misses = 0;
+                while( ip < mlimit )
+                {
+                    const std::uint32_t h = detail::Hash( detail::Read32( ip ) );
+                    const unsigned char *ref = src + table[ h ];
+                    table[ h ] = static_cast< std::uint32_t >( ip - src );
+                    if( ref >= ip || static_cast< std::size_t >( ip - ref ) > max_offset ||
+                        detail::Read32( ref ) != detail::Read32( ip ) )
+                    {
+                        // skip faster through incompressible data
+                        ip += 1 + ( misses++ >> 6 );
+                        continue;
+                    }
+                    misses = 0;
+
+                    while( ip > anchor && ref > src && ip[ -1 ] == ref[ -1 ] ){ --ip; --ref; }
+                    std::size_t len = min_match;
+                    while( ip + len < matchlimit && ip[ len ] == ref[ len ] ){ ++len; }
+
+                    op = detail::WriteSequence( op , oend , anchor , ip - anchor , ip - ref , len );
+                    if( op == 0 ){ return 0; }
+                    ip += len;
+                    anchor = ip;
+                    if( ip < mlimit )
+                    {
+                        table[ detail::Hash( detail::Read32( ip - 2 ) ) ] = static_cast< std::uint32_t >( ip - 2 - src );
+                    }
+                }
+            }
+            op = detail::WriteSequence( op , oend , anchor , end - anchor , 0 , 0 );
+            if( op == 0 ){ return 0; }
+            return op - reinterpret_cast< unsigned char* >( dest );
+        }
+
+        // decodes one block into exactly @n bytes , false on malformed input
+        inline bool DecompressBlock( const char *source , std::size_t size , char *dest , std::size_t n )
+        {
+            const unsigned char *ip = reinterpret_cast< const unsigned char* >( source );
+            const unsigned char *iend = ip + size;
+            unsigned char *const ostart = reinterpret_cast< unsigned char* >( dest );
+            unsigned char *op = ostart;
+            unsigned char *const oend = op + n;
+
+            while( ip < iend )
+            {
+                const unsigned token = *ip++;
+                std::size_t lit = token >> 4;
+                if( lit == 15 && detail::ReadLength( ip , iend , lit ) == false ){ return false; }
+                if( lit > static_cast< std::size_t >( iend - ip ) || lit > static_cast< std::size_t >( oend - op ) ){ return false; }
+                std::memcpy( op , ip , lit );
+                op += lit;
+                ip += lit;
+                if( ip == iend ){ break; }
+
+                if( iend - ip < 2 ){ return false; }
+                const std::size_t offset = ip[ 0 ] | ( std::size_t( ip[ 1 ] ) << 8 );
+                ip += 2;
+                if( offset == 0 || offset > static_cast< std::size_t >( op - ostart ) ){ return false; }
+
+                std::size_t len = token & 15;
+                if( len == 15 && detail::ReadLength( ip , iend , len ) == false ){ return false; }
+                len += min_match;
+                if( len > static_cast< std::size_t >( oend - op ) ){ return false; }
+
+                const unsigned char *match = op - offset;
+                if( offset >= len )
+                {
+                    std::memcpy( op , match , len );
+                    op += len;
+                }else if( offset >= 8 )
+                {
+                    // overlapping , but every 8 byte step reads bytes already written
+                    unsigned char *const mend = op + len;
+                    for( ; mend - op >= 8; op += 8 , match += 8 ){ std::memcpy( op , match , 8 ); }
+                    while( op < mend ){ *op++ = *match++; }
+                }else
+                {
+                    for( std::size_t i = 0; i < len; ++i ){ op[ i ] = match[ i ]; }
+                    op += len;
+                }
+            }
+            return op == oend;
+        }
+
+        // pool used by the container functions
+        inline ThreadPool& Pool()
+        {
+            static ThreadPool pool( std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 0 );
+            return pool;
+        }
+
+        // magic , version and flags match; other data starting with "EHLZ" is not a container
+        inline bool IsContainer( const char *data , std::size_t size )
+        {
+            if( size < sizeof( lz_header ) || std::memcmp( data , "EHLZ" , 4 ) != 0 ){ return false; }
+            lz_header header;
+            std::memcpy( &header , data , sizeof( header ) );
+            return header.version == format_version && header.flags == 0;
+        }
+        // the header of a container agrees with itself and with @size : block count ,
+        // a block table inside the input , and a decoded size the input can produce.
+        // checked before anything is allocated from it
+        inline bool IsValidHeader( const char *data , std::size_t size )
+        {
+            if( IsContainer( data , size ) == false ){ return false; }
+            lz_header header;
+            std::memcpy( &header , data , sizeof( header ) );
+            if( header.block_size == 0 ){ return false; }
+            const std::uint64_t blocks = header.raw_size / header.block_size + ( header.raw_size % header.block_size != 0 );
+            const std::uint64_t payload = size - sizeof( header );
+            return header.block_count == blocks &&
+                   blocks <= payload / sizeof( std::uint32_t ) &&
+                   header.raw_size / max_ratio <= payload &&
+                   header.raw_size < std::numeric_limits< std::size_t >::max();
+        }
+        // decoded size of a container , IsValidHeader() must hold
+        inline std::uint64_t RawSize( const char *data )
+        {
+            lz_header header;
+            std::memcpy( &header , data , sizeof( header ) );
+            return header.raw_size;
+        }
+
+        // @size bytes as a container of @block_size blocks , compressed on @pool.
+        // blocks that do not shrink are stored as is.
+        // empty ( a container never is ) if @size needs more than UINT32_MAX blocks
+        inline std::vector< char > Compress( const char *data , std::size_t size ,
+                std::uint32_t block_size = 1 << 18 , ThreadPool& pool = Pool() )
+        {
+            // a block size has to fit beside stored_flag in the block table
+            block_size = std::min( std::max< std::uint32_t >( block_size , 1 ) , stored_flag - 1 );
+            const std::size_t blocks = size / block_size + ( size % block_size != 0 );
+            if( blocks > std::numeric_limits< std::uint32_t >::max() )
+            {
+                return std::vector< char >();
+            }
+            std::vector< std::vector< char > > packed( blocks );
+            std::vector< std::uint32_t > table( blocks );
+            pool.ParallelFor( blocks , 1 , [ & ]( std::size_t first , std::size_t last )
+            {
+                for( std::size_t b = first; b < last; ++b )
+                {
+                    const char *src = data + b * block_size;
+                    const std::size_t n = std::min< std::size_t >( block_size , size - b * block_size );
+                    packed[ b ].resize( n );
+                    const std::size_t c = CompressBlock( src , n , packed[ b ].data() , n > 0 ? n - 1 : 0 );
+                    if( c )
+                    {
+                        packed[ b ].resize( c );
+                        table[ b ] = static_cast< std::uint32_t >( c );
+                    }else
+                    {
+                        std::memcpy( packed[ b ].data() , src , n );
+                        table[ b ] = static_cast< std::uint32_t >( n ) | stored_flag;
+                    }
+                }
+            });
+
+            lz_header header;
+            std::memcpy( header.magic , "EHLZ" , 4 );
+            header.block_size = block_size;
+            header.raw_size = size;
+            header.block_count = static_cast< std::uint32_t >( blocks );
+            header.version = format_version;
+            header.flags = 0;
+
+            std::vector< char > out( sizeof( header ) + blocks * sizeof( std::uint32_t ) );
+            std::memcpy( out.data() , &header , sizeof( header ) );
+            if( blocks ){ std::memcpy( out.data() + sizeof( header ) , table.data() , blocks * sizeof( std::uint32_t ) ); }
+            for( const auto& p : packed ){ out.insert( out.end() , p.begin() , p.end() ); }
+            return out;
+        }
+
+        // decodes a container into @out ( RawSize() bytes ) on @pool , false on malformed input
+        inline bool Decompress( const char *data , std::size_t size , char *out , ThreadPool& pool = Pool() )
+        {
+            if( IsValidHeader( data , size ) == false ){ return false; }
+            lz_header header;
+            std::memcpy( &header , data , sizeof( header ) );
+            const std::size_t blocks = header.block_count;
+
+            // block offsets in the input
+            std::vector< std::size_t > offsets( blocks + 1 );
+            offsets[ 0 ] = sizeof( header ) + blocks * sizeof( std::uint32_t );
+            for( std::size_t b = 0; b < blocks; ++b )
+            {
+                std::uint32_t c;
+                std::memcpy( &c , data + sizeof( header ) + b * sizeof( c ) , sizeof( c ) );
+                offsets[ b + 1 ] = offsets[ b ] + ( c & ~stored_flag );
+                if( offsets[ b + 1 ] > size ){ return false; }
+            }
+
+            std::atomic< bool > ok( true );
+            pool.ParallelFor( blocks , 1 , [ & ]( std::size_t first , std::size_t last )
+            {
+                for( std::size_t b = first; b < last; ++b )
+                {
+                    std::uint32_t c;
+                    std::memcpy( &c , data + sizeof( header ) + b * sizeof( c ) , sizeof( c ) );
+                    const std::size_t raw_first = b * header.block_size;
+                    const std::size_t n = std::min< std::size_t >( header.block_size , header.raw_size - raw_first );
+                    const char *src = data + offsets[ b ];
+                    const std::size_t csize = offsets[ b + 1 ] - offsets[ b ];
+                    if( c & stored_flag )
+                    {
+                        if( csize != n ){ ok = false; continue; }
+                        std::memcpy( out + raw_first , src , n );
+                    }else if( DecompressBlock( src , csize , out + raw_first , n ) == false )
+                    {
+                        ok = false;
+                    }
+                }
+            });
+            return ok;
+        }
+    };  // namespace LZ
+};  // namespace EH
@@ -3,6 +3,8 @@
 #include "../EHLog.h"
 #include <memory>
 #include <iostream>
+#include <new>
+#include <cstdlib>
 
 namespace EH
 {
@@ -13,6 +15,57 @@ namespace EH
         {
         }
     };
+
+    // std allocator returning memory aligned to @Align bytes
+    // ( SIMD loads , cache-line separated chunks )
+    template < typename T , std::size_t Align = 64 >
+    struct AlignedAllocator
+    {
+        static_assert( ( Align & ( Align - 1 ) ) == 0 , "alignment must be power of 2" );
+
+        using value_type = T;
+        constexpr static std::size_t alignment = Align < alignof( T ) ? alignof( T ) : Align;
+
+        template < typename U >
+        struct rebind
+        {
+            using other = AlignedAllocator< U , Align >;
+        };
+
+        AlignedAllocator() noexcept
+        {
+        }
+        template < typename U >
+        AlignedAllocator( const AlignedAllocator< U , Align >& ) noexcept
+        {
+        }
+
+        T* allocate( std::size_t n )
+        {
+            void *ptr = 0;
+            if( posix_memalign( &ptr , alignment < sizeof( void* ) ? sizeof( void* ) : alignment , n * sizeof( T ) ) )
+            {
+                throw std::bad_alloc();
+            }
+            return reinterpret_cast< T* >( ptr );
+        }
+        void deallocate( T *ptr , std::size_t )
+        {
+            std::free( ptr );
+        }
+
+        template < typename U >
+        bool operator == ( const AlignedAllocator< U , Align >& ) const
+        {
+            return true;
+        }
+        template < typename U >
+        bool operator != ( const AlignedAllocator< U , Align >& ) const
+        {
+            return false;
+        }
+    };
+
     template < typename T , typename Deleter = std::default_delete< T[] > >
     class Ptr
     {
@@ -0,0 +1,327 @@
+#pragma once
+
+#include "EHFile.h"
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <cstdint>
+#include <cstring>
+
+namespace EH
+{
+    namespace File
+    {
+        // Pack archive : many files in one, opened with a single mapping.
+        //
+        // layout ( little endian ) :
+        //  header                  pack_header
+        //  table of contents       pack_entry[ count ] , sorted by name hash
+        //  names                   concatenated , not null terminated
+        //  blobs                   each aligned to header.alignment, in the order they were added
+        //
+        // blobs keep the builder's order, so files added together are read ahead together.
+        struct pack_header
+        {
+            char magic[ 4 ];
+            std::uint32_t version;
+            std::uint32_t count;
+            std::uint32_t alignment;
+            std::uint64_t names_offset;
+            std::uint64_t names_size;
+        };
+        struct pack_entry
+        {
+            std::uint64_t hash;
+            std::uint64_t offset;
+            std::uint64_t size;
+            std::uint32_t name_offset;
+            std::uint32_t name_size;
+        };
+        static_assert( sizeof( pack_header ) == 32 , "pack_header layout" );
+        static_assert( sizeof( pack_entry ) == 32 , "pack_entry layout" );
+
+        constexpr std::uint32_t pack_version = 1;
+
+        // 64 bit FNV-1a
+        inline std::uint64_t PackHash( const char *s , std::size_t n )
+        {
+            std::uint64_t h = 14695981039346656037ULL;
+            for( std::size_t i = 0; i < n; ++i )
+            {
+                h ^= static_cast< unsigned char >( s[ i ] );
+                h *= 1099511628211ULL;
+            }
+            return h;
+        }
+
+        // collects files and writes a pack
+        //
+        //  PackBuilder builder;
+        //  builder.Add( "shader/basic.vert" , "assets/shader/basic.vert" );
+        //  builder.Write( "assets.pack" );
+        class PackBuilder
+        {
+        public:
+            explicit PackBuilder( std::uint32_t alignment = 64 ) :
+                alignment( alignment )
+            {
+            }
+
+            // the file at @path, stored as @name; read when Write() runs
+            void Add( std::string name , std::string path )
+            {
+                sources.push_back( source_type{ std::move( name ) , std::move( path ) , std::string() , false } );
+            }
+            // @size bytes from @data, copied now
+            void Add( std::string name , const char *data , std::size_t size )
+            {
+                sources.push_back( source_type{ std::move( name ) , std::string() , std::string( data , size ) , true } );
+            }
+
+            std::size_t Size() const
+            {
+                return sources.size();
+            }
+
+            // false if a source could not be read, a name is duplicated, or @output can not be written
+            bool Write( const char *output ) const
+            {
+                std::vector< MappedFile > files( sources.size() );
+                std::vector< pack_entry > toc( sources.size() );
+                std::string names;
+                for( std::size_t i = 0; i < sources.size(); ++i )
+                {
+                    const source_type& s = sources[ i ];
+                    if( s.inline_data == false )
+                    {
+                        files[ i ] = MapFile( s.path.c_str() , Access::Sequential );
+                        if( !files[ i ] ){ return false; }
+                    }
+                    toc[ i ].hash = PackHash( s.name.data() , s.name.size() );
+                    toc[ i ].name_offset = static_cast< std::uint32_t >( names.size() );
+                    toc[ i ].name_size = static_cast< std::uint32_t >( s.name.size() );
+                    toc[ i ].size = s.inline_data ? s.data.size() : files[ i ].size();
+                    names += s.name;
+                }
+
+                // blobs in insertion order
+                std::uint64_t offset = Align( sizeof( pack_header ) + toc.size() * sizeof( pack_entry ) + names.size() );
+                for( auto& e : toc )
+                {
+                    e.offset = offset;
+                    offset = Align( offset + e.size );
+                }
+
+                std::vector< std::size_t > order( toc.size() );
+                for( std::size_t i = 0; i < order.size(); ++i ){ order[ i ] = i; }
+                auto name_of = [ & ]( std::size_t i ) -> const std::string& { return sources[ i ].name; };
+                std::sort( order.begin() , order.end() , [ & ]( std::size_t a , std::size_t b )
+                {
+                    if( toc[ a ].hash != toc[ b ].hash ){ return toc[ a ].hash < toc[ b ].hash; }
+                    return name_of( a ) < name_of( b );
+                });
+                for( std::size_t i = 1; i < order.size(); ++i )
+                {
+                    if( name_of( order[ i - 1 ] ) == name_of( order[ i ] ) )
+                    {
+                        ERROR( "Pack : duplicated name " , name_of( order[ i ] ) );
+                        return false;
+                    }
+                }
+
+                std::ofstream out( output , std::ios_base::out | std::ios_base::binary | std::ios_base::trunc );
+                if( !out )
+                {
+                    ERROR( "Pack : can not write " , output );
+                    return false;
+                }
+                pack_header header;
+                std::memcpy( header.magic , "EHPK" , 4 );
+                header.version = pack_version;
+                header.count = static_cast< std::uint32_t >( toc.size() );
+                header.alignment = alignment;
+                header.names_offset = sizeof( pack_header ) + toc.size() * sizeof( pack_entry );
+                header.names_size = names.size();
+                out.write( reinterpret_cast< const char* >( &header ) , sizeof( header ) );
+                for( std::size_t i : order )
+                {
+                    out.write( reinterpret_cast< const char* >( &toc[ i ] ) , sizeof( pack_entry ) );
+                }
+                out.write( names.data() , names.size() );
+
+                std::uint64_t written = header.names_offset + names.size();
+                const std::string zeros( alignment , '\0' );
+                for( std::size_t i = 0; i < sources.size(); ++i )
+                {
+                    out.write( zeros.data() , toc[ i ].offset - written );
+                    const char *p = sources[ i ].inline_data ? sources[ i ].data.data() : files[ i ].data();
+                    out.write( p , toc[ i ].size );
+                    written = toc[ i ].offset + toc[ i ].size;
+                }
+                out.flush();
+                if( !out )
+                {
+                    ERROR( "Pack : write failed " , output );
+                    return false;
+                }
+                return true;
+            }
+
+        protected:
+            struct source_type
+            {
+                std::string name;
+                std::string path;
+                std::string data;
+                bool inline_data;
+            };
+
+            std::uint32_t alignment;
+            std::vector< source_type > sources;
+
+            std::uint64_t Align( std::uint64_t x ) const
+            {
+                const std::uint64_t a = alignment ? alignment : 1;
+                return ( x + a - 1 ) / a * a;
+            }
+        };
+
+        // read side : maps the archive once, lookups return views into the mapping
+        //
+        //  PackFile pack( "assets.pack" );
+        //  auto vert = pack.Find( "shader/basic.vert" );
+        //  if( vert ){ Compile( vert.data , vert.size ); }
+        class PackFile
+        {
+        public:
+            struct view_type
+            {
+                const char *data;
+                std::size_t size;
+
+                explicit operator bool () const
+                {
+                    return data != 0;
+                }
+                const char* begin() const
+                {
+                    return data;
+                }
+                const char* end() const
+                {
+                    return data + size;
+                }
+            };
+
+            PackFile() :
+                toc( 0 ) , names( 0 ) , count( 0 )
+            {
+            }
+            explicit PackFile( const char *name , Access access = Access::Normal ) :
+                PackFile()
+            {
+                Open( name , access );
+            }
+
+            // false if the file is missing or not a valid pack
+            bool Open( const char *name , Access access = Access::Normal )
+            {
+                file = MapFile( name , access );
+                toc = 0;
+                names = 0;
+                count = 0;
+                if( !file ){ return false; }
+
+                pack_header header;
+                if( file.size() < sizeof( header ) )
+                {
+                    return Invalid( name );
+                }
+                std::memcpy( &header , file.data() , sizeof( header ) );
+                if( std::memcmp( header.magic , "EHPK" , 4 ) || header.version != pack_version ||
+                    header.names_offset != sizeof( header ) + std::uint64_t( header.count ) * sizeof( pack_entry ) ||
+                    header.names_offset > file.size() || header.names_size > file.size() - header.names_offset )
+                {
+                    return Invalid( name );
+                }
+                toc = reinterpret_cast< const pack_entry* >( file.data() + sizeof( header ) );
+                names = file.data() + header.names_offset;
+                count = header.count;
+                // subtracted , not added : a crafted size must not wrap past the checks.
+                // Find() binary searches the table , so it has to be sorted
+                for( std::size_t i = 0; i < count; ++i )
+                {
+                    if( toc[ i ].offset > file.size() || toc[ i ].size > file.size() - toc[ i ].offset ||
+                        toc[ i ].name_offset > header.names_size || toc[ i ].name_size > header.names_size - toc[ i ].name_offset ||
+                        ( i && toc[ i ].hash < toc[ i - 1 ].hash ) )
+                    {
+                        return Invalid( name );
+                    }
+                }
+                return true;
+            }
+
+            explicit operator bool () const
+            {
+                return toc != 0;
+            }
+
+            // empty view if @name is not in the pack
+            view_type Find( const char *name , std::size_t length ) const
+            {
+                const std::uint64_t hash = PackHash( name , length );
+                const pack_entry *e = std::lower_bound( toc , toc + count , hash ,
+                        []( const pack_entry& a , std::uint64_t h ){ return a.hash < h; } );
+                for( ; e != toc + count && e->hash == hash; ++e )
+                {
+                    if( e->name_size == length && std::memcmp( names + e->name_offset , name , length ) == 0 )
+                    {
+                        return view_type{ file.data() + e->offset , static_cast< std::size_t >( e->size ) };
+                    }
+                }
+                return view_type{ 0 , 0 };
+            }
+            view_type Find( const std::string& name ) const
+            {
+                return Find( name.data() , name.size() );
+            }
+
+            // entries in table order ( by hash )
+            std::size_t Size() const
+            {
+                return count;
+            }
+            std::string Name( std::size_t i ) const
+            {
+                return std::string( names + toc[ i ].name_offset , toc[ i ].name_size );
+            }
+            view_type At( std::size_t i ) const
+            {
+                return view_type{ file.data() + toc[ i ].offset , static_cast< std::size_t >( toc[ i ].size ) };
+            }
+
+            const MappedFile& Mapping() const
+            {
+                return file;
+            }
+
+        protected:
+            MappedFile file;
+            const pack_entry *toc;
+            const char *names;
+            std::size_t count;
+
+            bool Invalid( const char *name )
+            {
+                ERROR( "Pack : not a valid pack " , name );
+                file = MappedFile();
+                toc = 0;
+                names = 0;
+                count = 0;
+                return false;
+            }
+        };
+    };  // namespace File
+};  // namespace EH
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <exception>
+
+namespace EH
+{
+    // Work stealing thread pool.
+    // every worker owns a deque : it pops its own work from the back and,
+    // when empty, steals from the front of the others.
+    // a thread waiting in ParallelFor() runs tasks too instead of sleeping,
+    // so ThreadPool( 0 ) is a valid single threaded pool.
+    class ThreadPool
+    {
+    public:
+        using task_type = std::function< void() >;
+
+        explicit ThreadPool( std::size_t threads = std::thread::hardware_concurrency() ) :
+            queues( std::max< std::size_t >( threads , 1 ) ) ,
+            pending( 0 ) ,
+            next( 0 ) ,
+            stop( false )
+        {
+            for( std::size_t i = 0; i < queues.size(); ++i )
+            {
+                queues[ i ].reset( new queue_type() );
+            }
+            for( std::size_t i = 0; i < threads; ++i )
+            {
+                workers.emplace_back( [ this , i ](){ WorkerLoop( i ); } );
+            }
+        }
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard< std::mutex > lock( sleep_mutex );
+                stop = true;
+            }
+            sleep_cv.notify_all();
+            for( auto& w : workers )
+            {
+                w.join();
+            }
+        }
+        ThreadPool( const ThreadPool& ) = delete;
+        ThreadPool& operator = ( const ThreadPool& ) = delete;
+
+        // number of worker threads, not counting callers that help
+        std::size_t Size() const
+        {
+            return workers.size();
+        }
+
+        void Push( task_type task )
+        {
+            const std::size_t q = Home();
+            Announce( 1 );
+            {
+                std::lock_guard< std::mutex > lock( queues[ q ]->mutex );
+                queues[ q ]->tasks.push_back( std::move( task ) );
+            }
+            sleep_cv.notify_one();
+        }
+
+        // run one queued task on the calling thread, false if there was none
+        bool RunOne()
+        {
+            task_type task;
+            if( Pop( Home() , task ) == false ){ return false; }
+            task();
+            return true;
+        }
+
+        // body( first , last ) over [ 0 , n ) in chunks of @grain elements.
+        // returns once every chunk is done; the caller executes chunks meanwhile.
+        // if a chunk throws , the chunks not yet started are skipped and the first
+        // exception is rethrown here
+        template < typename F >
+        void ParallelFor( std::size_t n , std::size_t grain , F&& body )
+        {
+            if( n == 0 ){ return; }
+            grain = std::max< std::size_t >( grain , 1 );
+            const std::size_t chunks = ( n + grain - 1 ) / grain;
+            if( chunks == 1 || workers.empty() )
+            {
+                body( std::size_t( 0 ) , n );
+                return;
+            }
+
+            std::atomic< std::size_t > left( chunks );
+            std::atomic< bool > failed( false );
+            std::exception_ptr error;
+            Announce( chunks );
+            // spread the chunks over every queue so idle workers start without stealing
+            for( std::size_t c = 0; c < chunks; ++c )
+            {
+                const std::size_t first = c * grain;
+                const std::size_t last  = std::min( first + grain , n );
+                queue_type& q = *queues[ c % queues.size() ];
+                std::lock_guard< std::mutex > lock( q.mutex );
+                q.tasks.push_back( [ &body , &left , &failed , &error , first , last ]()
+                {
+                    if( failed.load( std::memory_order_relaxed ) == false )
+                    {
+                        try
+                        {
+                            body( first , last );
+                        }catch( ... )
+                        {
+                            // only the first one is kept; left is still counted down below
+                            if( failed.exchange( true , std::memory_order_relaxed ) == false )
+                            {
+                                error = std::current_exception();
+                            }
+                        }
+                    }
+                    left.fetch_sub( 1 , std::memory_order_acq_rel );
+                });
+            }
+            sleep_cv.notify_all();
+
+            while( left.load( std::memory_order_acquire ) )
+            {
+                if( RunOne() == false )
+                {
+                    std::this_thread::yield();
+                }
+            }
+            if( error ){ std::rethrow_exception( error ); }
+        }
+
+    protected:
+        struct queue_type
+        {
+            std::mutex mutex;
+            std::deque< task_type > tasks;
+        };
+
+        std::vector< std::unique_ptr< queue_type > > queues;
+        std::vector< std::thread > workers;
+
+        std::atomic< std::size_t > pending;
+        std::atomic< std::size_t > next;
+
+        std::mutex sleep_mutex;
+        std::condition_variable sleep_cv;
+        bool stop;
+
+        // count tasks before they become visible , under the sleep mutex so a worker
+        // that just found nothing cannot miss the wakeup
+        void Announce( std::size_t n )
+        {
+            std::lock_guard< std::mutex > lock( sleep_mutex );
+            pending.fetch_add( n , std::memory_order_release );
+        }
+
+        // the pool a thread works for and its queue there
+        struct worker_id
+        {
+            const ThreadPool *pool;
+            std::size_t index;
+        };
+
+        // queue owned by the calling worker , round robin for outside threads
+        // and for workers of other pools
+        std::size_t Home()
+        {
+            const worker_id& self = Worker();
+            if( self.pool == this ){ return self.index; }
+            return next.fetch_add( 1 , std::memory_order_relaxed ) % queues.size();
+        }
+        static worker_id& Worker()
+        {
+            static thread_local worker_id id{ 0 , 0 };
+            return id;
+        }
+
+        bool Pop( std::size_t home , task_type& task )
+        {
+            if( pending.load( std::memory_order_acquire ) == 0 ){ return false; }
+            {
+                queue_type& q = *queues[ home ];
+                std::lock_guard< std::mutex > lock( q.mutex );
+                if( q.tasks.empty() == false )
+                {
+                    task = std::move( q.tasks.back() );
+                    q.tasks.pop_back();
+                    pending.fetch_sub( 1 , std::memory_order_acq_rel );
+                    return true;
+                }
+            }
+            for( std::size_t i = 1; i < queues.size(); ++i )
+            {
+                queue_type& q = *queues[ ( home + i ) % queues.size() ];
+                std::lock_guard< std::mutex > lock( q.mutex );
+                if( q.tasks.empty() == false )
+                {
+                    task = std::move( q.tasks.front() );
+                    q.tasks.pop_front();
+                    pending.fetch_sub( 1 , std::memory_order_acq_rel );
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void WorkerLoop( std::size_t index )
+        {
+            Worker() = worker_id{ this , index };
+            task_type task;
+            while( true )
+            {
+                if( Pop( index , task ) )
+                {
+                    task();
+                    task = nullptr;
+                    continue;
+                }
+                std::unique_lock< std::mutex > lock( sleep_mutex );
+                sleep_cv.wait( lock , [ this ](){ return stop || pending.load( std::memory_order_acquire ) > 0; } );
+                if( stop && pending.load( std::memory_order_acquire ) == 0 ){ return; }
+            }
+        }
+    };
+};  // namespace EH
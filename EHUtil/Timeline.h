@@ -0,0 +1,288 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <functional>
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+
+#include "Memory.h"
+#include "ThreadPool.h"
+#include "Tween.h"
+
+namespace EH
+{
+    namespace Util
+    {
+        namespace Tween
+        {
+            // Owns every running tween and advances them together.
+            //
+            // Active tweens live in dense, index-aligned arrays ( structure of arrays ),
+            // so one Update() is a single linear pass over them; removal swaps the last
+            // tween into the hole. Finished tweens leave through a min-heap ordered by
+            // end time, so Update() never scans for completion, and their callbacks are
+            // fired together after the pass.
+            //
+            //  struct MyFrame : EH::Frame< MyFrame >
+            //  {
+            //      Timeline<> timeline;
+            //      void EnterFrame(){ timeline.Update( GetDT() ); ... }
+            //  };
+            template < typename T = float >
+            class Timeline
+            {
+            public:
+                struct handle_type
+                {
+                    std::uint32_t slot;
+                    std::uint32_t generation;
+                };
+                using callback_type = std::function< void( handle_type ) >;
+
+                template < typename U >
+                using array_type = std::vector< U , AlignedAllocator< U , 64 > >;
+
+                Timeline() :
+                    time( 0 )
+                {
+                }
+
+                // tween @target ( may be null ) from @from to @to over @duration seconds,
+                // starting after @delay seconds, eased by @ease.
+                // @on_complete is called once the tween reached @to.
+                handle_type Add( T from , T to , float duration ,
+                        const Interpolater< T >& ease = Interpolater< T >( 0 ) ,
+                        T *target = nullptr ,
+                        callback_type on_complete = callback_type() ,
+                        float delay = 0 )
+                {
+                    const std::uint32_t slot = AcquireSlot();
+                    const std::uint32_t dense = static_cast< std::uint32_t >( elapsed.size() );
+                    slots[ slot ].dense = dense;
+
+                    const T coeff = ease.GetCoeff();
+                    elapsed.push_back( -delay );
+                    inv_duration.push_back( duration > 0 ? 1.0f / duration : std::numeric_limits< float >::max() );
+                    start_value.push_back( from );
+                    delta_value.push_back( to - from );
+                    this->coeff.push_back( coeff );
+                    mkp1.push_back( -coeff + T(1) );
+                    value.push_back( from );
+                    targets.push_back( target );
+                    callbacks.push_back( std::move( on_complete ) );
+                    owner.push_back( slot );
+
+                    const handle_type handle{ slot , slots[ slot ].generation };
+                    retire_queue.push( retire_type{ time + delay + duration , handle } );
+                    return handle;
+                }
+
+                // stop a tween where it is, without calling its callback
+                bool Cancel( handle_type handle )
+                {
+                    if( IsActive( handle ) == false ){ return false; }
+                    Remove( slots[ handle.slot ].dense );
+                    return true;
+                }
+
+                bool IsActive( handle_type handle ) const
+                {
+                    return handle.slot < slots.size() &&
+                           slots[ handle.slot ].generation == handle.generation &&
+                           slots[ handle.slot ].dense != invalid;
+                }
+                // current value of an active tween, T() once it finished or was cancelled
+                T Value( handle_type handle ) const
+                {
+                    if( IsActive( handle ) == false ){ return T(); }
+                    return value[ slots[ handle.slot ].dense ];
+                }
+
+                std::size_t Size() const
+                {
+                    return elapsed.size();
+                }
+                double Time() const
+                {
+                    return time;
+                }
+
+                // advance every tween by @dt seconds
+                void Update( float dt )
+                {
+                    time += dt;
+                    Advance( dt , 0 , elapsed.size() );
+                    WriteTargets( 0 , elapsed.size() );
+                    Retire();
+                }
+
+                // same as Update( dt ), the tween arrays are split over @pool.
+                // chunks are whole multiples of 64 elements, so with the 64 byte aligned
+                // arrays no two chunks write to the same cache line
+                // ( targets are the caller's memory and may still share lines ).
+                //
+                // every tween writes its target from whichever thread runs its chunk :
+                // two active tweens must not share a target here, that is a data race.
+                // use Update( dt ) while they do.
+                void Update( float dt , ThreadPool& pool , std::size_t grain = 4096 )
+                {
+                    time += dt;
+                    grain = ( ( grain + 63 ) / 64 ) * 64;
+                    pool.ParallelFor( elapsed.size() , grain , [ this , dt ]( std::size_t first , std::size_t last )
+                    {
+                        Advance( dt , first , last );
+                        WriteTargets( first , last );
+                    });
+                    Retire();
+                }
+
+            protected:
+                constexpr static std::uint32_t invalid = std::numeric_limits< std::uint32_t >::max();
+
+                struct slot_type
+                {
+                    std::uint32_t dense;
+                    std::uint32_t generation;
+                };
+                struct retire_type
+                {
+                    double end;
+                    handle_type handle;
+
+                    bool operator > ( const retire_type& rhs ) const
+                    {
+                        return end > rhs.end;
+                    }
+                };
+
+                double time;
+
+                // hot , dense
+                array_type< float > elapsed;
+                array_type< float > inv_duration;
+                array_type< T > start_value;
+                array_type< T > delta_value;
+                array_type< T > coeff;
+                array_type< T > mkp1;
+                array_type< T > value;
+                std::vector< T* > targets;
+
+                // cold , dense
+                std::vector< callback_type > callbacks;
+                std::vector< std::uint32_t > owner;
+
+                // handle -> dense index
+                std::vector< slot_type > slots;
+                std::vector< std::uint32_t > free_slots;
+
+                std::priority_queue< retire_type , std::vector< retire_type > , std::greater< retire_type > > retire_queue;
+
+                // reused between frames
+                std::vector< std::pair< handle_type , callback_type > > retired;
+
+                // branch free, vectorizable body : clamp + Interpolater polynomial + lerp
+                void Advance( float dt , std::size_t first , std::size_t last )
+                {
+                    float *el = elapsed.data();
+                    const float *inv = inv_duration.data();
+                    const T *from = start_value.data();
+                    const T *delta = delta_value.data();
+                    const T *c = coeff.data();
+                    const T *k = mkp1.data();
+                    T *out = value.data();
+                    for( std::size_t i = first; i < last; ++i )
+                    {
+                        el[ i ] += dt;
+                        const T u = std::min( std::max( el[ i ] * inv[ i ] , 0.0f ) , 1.0f );
+                        out[ i ] = from[ i ] + delta[ i ] * ( c[ i ] * u*u + k[ i ] * u );
+                    }
+                }
+                void WriteTargets( std::size_t first , std::size_t last )
+                {
+                    for( std::size_t i = first; i < last; ++i )
+                    {
+                        if( targets[ i ] ){ *targets[ i ] = value[ i ]; }
+                    }
+                }
+
+                void Retire()
+                {
+                    while( retire_queue.empty() == false && retire_queue.top().end <= time )
+                    {
+                        const handle_type handle = retire_queue.top().handle;
+                        retire_queue.pop();
+                        // cancelled tweens leave stale entries behind
+                        if( IsActive( handle ) == false ){ continue; }
+
+                        const std::uint32_t dense = slots[ handle.slot ].dense;
+                        // land exactly on the end value
+                        value[ dense ] = start_value[ dense ] + delta_value[ dense ];
+                        if( targets[ dense ] ){ *targets[ dense ] = value[ dense ]; }
+
+                        if( callbacks[ dense ] )
+                        {
+                            retired.emplace_back( handle , std::move( callbacks[ dense ] ) );
+                        }
+                        Remove( dense );
+                    }
+
+                    // callbacks may Add() new tweens , fire them after the arrays are consistent
+                    for( auto& r : retired )
+                    {
+                        r.second( r.first );
+                    }
+                    retired.clear();
+                }
+
+                std::uint32_t AcquireSlot()
+                {
+                    if( free_slots.empty() )
+                    {
+                        slots.push_back( slot_type{ invalid , 0 } );
+                        return static_cast< std::uint32_t >( slots.size() - 1 );
+                    }
+                    const std::uint32_t slot = free_slots.back();
+                    free_slots.pop_back();
+                    return slot;
+                }
+
+                // swap the last tween into @dense
+                void Remove( std::uint32_t dense )
+                {
+                    const std::uint32_t last = static_cast< std::uint32_t >( elapsed.size() - 1 );
+                    const std::uint32_t slot = owner[ dense ];
+                    if( dense != last )
+                    {
+                        elapsed[ dense ]      = elapsed[ last ];
+                        inv_duration[ dense ] = inv_duration[ last ];
+                        start_value[ dense ]  = start_value[ last ];
+                        delta_value[ dense ]  = delta_value[ last ];
+                        coeff[ dense ]        = coeff[ last ];
+                        mkp1[ dense ]         = mkp1[ last ];
+                        value[ dense ]        = value[ last ];
+                        targets[ dense ]      = targets[ last ];
+                        callbacks[ dense ]    = std::move( callbacks[ last ] );
+                        owner[ dense ]        = owner[ last ];
+                        slots[ owner[ dense ] ].dense = dense;
+                    }
+                    elapsed.pop_back();
+                    inv_duration.pop_back();
+                    start_value.pop_back();
+                    delta_value.pop_back();
+                    coeff.pop_back();
+                    mkp1.pop_back();
+                    value.pop_back();
+                    targets.pop_back();
+                    callbacks.pop_back();
+                    owner.pop_back();
+
+                    slots[ slot ].dense = invalid;
+                    ++slots[ slot ].generation;
+                    free_slots.push_back( slot );
+                }
+            };
+        };  // namespace Tween
+    };  // namespace Util
+};  // namespace EH
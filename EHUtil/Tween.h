@@ -4,6 +4,10 @@
 #include <array>
 #include <cassert>
 #include <cmath>
+#include <algorithm>
+
+#include "Memory.h"
+#include "TweenSIMD.h"
 
 namespace EH
 {
@@ -38,6 +42,10 @@ namespace EH
                     m_coeff =  coeff;
                     mkp1    = -coeff + T(1);
                 }
+                constexpr inline T GetCoeff() const
+                {
+                    return m_coeff;
+                }
 
                 constexpr T operator () ( T t ) const
                 {
@@ -95,7 +103,206 @@ namespace EH
                         (   t3/6 -        t1/6     ) * base_type::container[ index + 2 ];
 
                 }
+
+                // batch evaluation : out[ i ] = (*this)( t[ i ] ) for i in [ 0 , n )
+                void operator () ( const float *t , T *out , std::size_t n )
+                {
+                    SIMD::Batch< SIMD::CubicBasis >( *this , t , out , n );
+                }
+            };
+
+            // CubicTweener with the basis pre-multiplied into the control points.
+            // segment k ( k in [ 1 , sizei - 3 ] ) is stored as
+            //      a + b*t1 + c*t1^2 + d*t1^3
+            // so a sample is the segment lookup plus one Horner step.
+            //
+            // call Bake() after filling container / sizef / sizei,
+            // use Set() to move single control points afterwards.
+            template < typename T , typename Container >
+            struct BakedCubicTweener : BaseTweener< Container >
+            {
+                typedef BaseTweener< Container > base_type;
+
+                struct alignas( alignof( T ) > 16 ? alignof( T ) : 16 ) segment_type
+                {
+                    T a , b , c , d;
+                };
+                std::vector< segment_type , AlignedAllocator< segment_type , 64 > > segments;
+
+                // bumped whenever segments change, lets derived tables rebuild lazily
+                std::size_t version = 0;
+
+                // rebuild every segment from the container
+                void Bake()
+                {
+                    assert( base_type::sizei >= 4 );
+                    segments.resize( base_type::sizei - 3 );
+                    Rebake( 1 , base_type::sizei - 3 );
+                }
+
+                // move control point @i, only segments using it are rebuilt
+                void Set( std::size_t i , const T& value )
+                {
+                    base_type::container[ i ] = value;
+                    Rebake( i > 3 ? i - 2 : 1 , std::min( i + 1 , base_type::sizei - 3 ) );
+                }
+
+                // rebuild segments [ first , last ]
+                void Rebake( std::size_t first , std::size_t last )
+                {
+                    ++version;
+                    for( std::size_t k = first; k <= last; ++k )
+                    {
+                        const T& p0 = base_type::container[ k - 1 ];
+                        const T& p1 = base_type::container[ k     ];
+                        const T& p2 = base_type::container[ k + 1 ];
+                        const T& p3 = base_type::container[ k + 2 ];
+
+                        segment_type& s = segments[ k - 1 ];
+                        // same weights as CubicTweener, collected by power of t1
+                        s.a = p1;
+                        s.b = ( 1.0f/3 )*p0 - 0.5f*p1 + p2 - ( 1.0f/6 )*p3;
+                        s.c = 0.5f*p0 - p1 + 0.5f*p2;
+                        s.d = ( -1.0f/6 )*p0 - 0.5f*p1 - 0.5f*p2 + ( 1.0f/6 )*p3;
+                    }
+                }
+
+                T operator ()( float t ) const
+                {
+                    float t1;
+                    std::size_t index;
+                    if( t < 1 )
+                    {
+                        index = 1;
+                        t1 = t - 1;
+                    }else if( t < base_type::sizef - 2 )
+                    {
+                        const float flr = std::floor( t );
+                        index = ( decltype(index) )flr;
+                        t1 = t - flr;
+                    }else
+                    {
+                        index = base_type::sizei - 3;
+                        t1 = t - std::floor( t ) + 1;
+                    }
+                    const segment_type& s = segments[ index - 1 ];
+                    return s.a + t1*( s.b + t1*( s.c + t1*s.d ) );
+                }
+            };
+
+            // samples a BakedCubicTweener at start, start + step, start + 2*step, ...
+            // inside a segment the cubic is walked with forward differences ( three adds per sample ),
+            // the differences are re-seeded from the segment coefficients at every segment boundary,
+            // which also bounds the accumulated rounding error to one segment.
+            template < typename T , typename Container >
+            struct CubicStream
+            {
+                typedef BakedCubicTweener< T , Container > spline_type;
+
+                // samples @curve at @t0 , @t0 + @dt , ... ; @dt must be positive
+                CubicStream( const spline_type& curve , float t0 , float dt ) :
+                    spline( &curve ) , start( t0 ) , step( dt ) , count( 0 ) , left( 0 )
+                {
+                    assert( dt > 0 );
+                }
+
+                // next sample
+                T operator () ()
+                {
+                    if( left == 0 ){ Seed(); }
+                    const T ret = f;
+                    f  += d1;
+                    d1 += d2;
+                    d2 += d3;
+                    --left;
+                    ++count;
+                    return ret;
+                }
+
+                // next @n samples
+                void operator () ( T *out , std::size_t n )
+                {
+                    while( n )
+                    {
+                        if( left == 0 ){ Seed(); }
+                        const std::size_t run = left < n ? left : n;
+                        for( std::size_t i = 0; i < run; ++i )
+                        {
+                            out[ i ] = f;
+                            f  += d1;
+                            d1 += d2;
+                            d2 += d3;
+                        }
+                        out   += run;
+                        n     -= run;
+                        left  -= run;
+                        count += run;
+                    }
+                }
+
+            protected:
+                const spline_type *spline;
+                double start;
+                double step;
+
+                // samples produced so far , samples left in the current segment
+                std::size_t count;
+                std::size_t left;
+
+                // value and forward differences of the current sample
+                T f , d1 , d2 , d3;
+
+                float Parameter( std::size_t i ) const
+                {
+                    return static_cast< float >( start + step * static_cast< double >( i ) );
+                }
+
+                // same segment choice as BakedCubicTweener::operator(),
+                // plus the parameter where that choice next changes
+                void Seed()
+                {
+                    const double t = start + step * static_cast< double >( count );
+                    const float tf = static_cast< float >( t );
+
+                    float t1;
+                    std::size_t index;
+                    double end;
+                    if( tf < 1 )
+                    {
+                        index = 1;
+                        t1 = tf - 1;
+                        end = 1;
+                    }else if( tf < spline->sizef - 2 )
+                    {
+                        const float flr = std::floor( tf );
+                        index = ( decltype(index) )flr;
+                        t1 = tf - flr;
+                        end = flr + 1;
+                    }else
+                    {
+                        const float flr = std::floor( tf );
+                        index = spline->sizei - 3;
+                        t1 = tf - flr + 1;
+                        end = flr + 1;
+                    }
+                    const double samples = std::ceil( ( end - t ) / step );
+                    left = samples < 1 ? 1 : static_cast< std::size_t >( samples );
+                    // the tweener decides on the float parameter, so must we
+                    while( left > 1 && Parameter( count + left - 1 ) >= end ){ --left; }
+                    while( Parameter( count + left ) < end ){ ++left; }
+
+                    const auto& s = spline->segments[ index - 1 ];
+                    const float h  = static_cast< float >( step );
+                    const float h2 = h * h;
+                    const float h3 = h2 * h;
+                    const float u  = t1;
+                    f  = s.a + u*( s.b + u*( s.c + u*s.d ) );
+                    d1 = h*s.b + ( 2*u*h + h2 )*s.c + ( 3*u*u*h + 3*u*h2 + h3 )*s.d;
+                    d2 = ( 2*h2 )*s.c + ( 6*u*h2 + 6*h3 )*s.d;
+                    d3 = ( 6*h3 )*s.d;
+                }
             };
+
             template < typename T , typename Container >
             struct MonotoneCubicTweener : BaseTweener< Container >
             {
@@ -127,6 +334,12 @@ namespace EH
                         ( - t2   +  1   ) * base_type::container[ index     ] +
                         (   t2/2 + t1/2 ) * base_type::container[ index + 1 ];
                 }
+
+                // batch evaluation : out[ i ] = (*this)( t[ i ] ) for i in [ 0 , n )
+                void operator () ( const float *t , T *out , std::size_t n )
+                {
+                    SIMD::Batch< SIMD::MonotoneCubicBasis >( *this , t , out , n );
+                }
             };
 
             template < typename T , typename Container >
@@ -165,7 +378,79 @@ namespace EH
                         +m0*(t3 - 0.5f*t2 - 0.25f*t1 + 0.25f)
                         +m1*(t3 + 0.5f*t2 - 0.25f*t1 - 0.25f);
                 }
+
+                // batch evaluation : out[ i ] = (*this)( t[ i ] ) for i in [ 0 , n )
+                void operator () ( const float *t , T *out , std::size_t n )
+                {
+                    SIMD::Batch< SIMD::MonotoneSquareBasis >( *this , t , out , n );
+                }
+            };
+
+            // @N float channels ( e.g. xyz + rgba ) driven by one parameter t.
+            // control points are stored channel-major ( structure of arrays ) :
+            //      channel c , point i  ->  points[ c*stride + i ]
+            // @Basis is one of SIMD::CubicBasis , SIMD::MonotoneCubicBasis , SIMD::MonotoneSquareBasis
+            template < std::size_t N , typename Basis >
+            struct MultiChannelTweener
+            {
+                std::vector< float , AlignedAllocator< float , 64 > > points;
+                std::size_t stride;
+                float sizef;
+                std::size_t sizei;
+
+                MultiChannelTweener() :
+                    stride( 0 ) , sizef( 0 ) , sizei( 0 )
+                {
+                }
+                MultiChannelTweener( std::size_t size )
+                {
+                    Resize( size );
+                }
+
+                // @size control points per channel, zero filled
+                // each channel starts on its own cache line
+                void Resize( std::size_t size )
+                {
+                    sizei  = size;
+                    sizef  = static_cast< float >( size );
+                    stride = ( size + 15 ) & ~std::size_t( 15 );
+                    points.assign( N * stride , 0.0f );
+                }
+
+                float* Channel( std::size_t c )
+                {
+                    return points.data() + c*stride;
+                }
+                const float* Channel( std::size_t c ) const
+                {
+                    return points.data() + c*stride;
+                }
+
+                // out[ c ] = channel c at t , for c in [ 0 , N )
+                void operator () ( float t , float *out ) const
+                {
+                    SIMD::EvaluateChannels< Basis >( points.data() , stride , N , sizef , sizei , t , out );
+                }
+                std::array< float , N > operator () ( float t ) const
+                {
+                    std::array< float , N > ret;
+                    (*this)( t , ret.data() );
+                    return ret;
+                }
+
+                // out[ c*out_stride + i ] = channel c at t[ i ] , for i in [ 0 , n )
+                void operator () ( const float *t , float *out , std::size_t out_stride , std::size_t n ) const
+                {
+                    SIMD::EvaluateChannels< Basis >( points.data() , stride , N , sizef , sizei , t , out , out_stride , n );
+                }
             };
+
+            template < std::size_t N >
+            using MultiCubicTweener = MultiChannelTweener< N , SIMD::CubicBasis >;
+            template < std::size_t N >
+            using MultiMonotoneCubicTweener = MultiChannelTweener< N , SIMD::MonotoneCubicBasis >;
+            template < std::size_t N >
+            using MultiMonotoneSquareTweener = MultiChannelTweener< N , SIMD::MonotoneSquareBasis >;
         };  // namespace Tween
     };  // namespace Util
 };  // namespace EH
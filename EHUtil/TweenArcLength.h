@@ -0,0 +1,152 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include "Tween.h"
+
+namespace EH
+{
+    namespace Util
+    {
+        namespace Tween
+        {
+            // length of a curve derivative, the speed.
+            // scalar curves use | v |, vector valued curves pass their own norm.
+            struct ArcLengthNorm
+            {
+                template < typename T >
+                float operator () ( const T& v ) const
+                {
+                    using std::abs;
+                    return static_cast< float >( abs( v ) );
+                }
+            };
+
+            // BakedCubicTweener traversed at constant speed.
+            // operator()( u ) , u in [ 0 , 1 ] , returns the point at u * Length() along the curve
+            // ( the parameter range [ 0 , sizef - 1 ] is covered ).
+            //
+            // a table of cumulative arc length is kept at @resolution entries per control point;
+            // the inverse is a binary search in it, a linear guess, and one Newton step
+            // against the tabulated length and speed.
+            // the table is rebuilt on first use after Bake() / Set() changed the segments.
+            // that rebuild writes from const members without synchronisation, so a
+            // tweener is not thread safe on its own : call Length() once after every
+            // change, before other threads evaluate it, and the const calls only read.
+            template < typename T , typename Container , typename Norm = ArcLengthNorm >
+            struct ArcLengthTweener : BakedCubicTweener< T , Container >
+            {
+                typedef BakedCubicTweener< T , Container > baked_type;
+                typedef BaseTweener< Container > base_type;
+
+                std::size_t resolution = 8;
+                Norm norm;
+
+                T operator () ( float u ) const
+                {
+                    return Position( Parameter( u * Length() ) );
+                }
+
+                // the curve at parameter @t. the baked evaluator wraps t = sizef - 1 back
+                // to the start of the last segment, here the end of the curve stays on
+                // the last segment ( local t = 2 ), matching Speed()
+                T Position( float t ) const
+                {
+                    if( t < base_type::sizef - 1 ){ return baked_type::operator()( t ); }
+                    const auto& s = baked_type::segments[ base_type::sizei - 4 ];
+                    const float t1 = t - ( base_type::sizef - 3 );
+                    return s.a + t1*( s.b + t1*( s.c + t1*s.d ) );
+                }
+
+                float Length() const
+                {
+                    Update();
+                    return lengths.back();
+                }
+
+                // curve parameter where the arc length from 0 reaches @distance
+                float Parameter( float distance ) const
+                {
+                    Update();
+                    if( distance <= 0 ){ return 0; }
+                    if( distance >= lengths.back() ){ return base_type::sizef - 1; }
+
+                    const std::size_t j = static_cast< std::size_t >(
+                            std::upper_bound( lengths.begin() , lengths.end() , distance ) - lengths.begin() ) - 1;
+                    const float t0 = j * dt;
+                    const float span = lengths[ j + 1 ] - lengths[ j ];
+                    float t = span > 0 ? t0 + dt * ( distance - lengths[ j ] ) / span : t0;
+
+                    // Newton : L( t ) - distance = 0 , L' = speed ,
+                    // L( t ) from the table entry plus a trapezoid over [ t0 , t ]
+                    const float speed = Speed( t );
+                    if( speed > 0 )
+                    {
+                        const float length = lengths[ j ] + 0.5f * ( t - t0 ) * ( speeds[ j ] + speed );
+                        t -= ( length - distance ) / speed;
+                        t = std::min( std::max( t , t0 ) , t0 + dt );
+                    }
+                    return t;
+                }
+
+                // | dp/dt |
+                float Speed( float t ) const
+                {
+                    float t1;
+                    std::size_t index;
+                    if( t < 1 )
+                    {
+                        index = 1;
+                        t1 = t - 1;
+                    }else if( t < base_type::sizef - 2 )
+                    {
+                        const float flr = std::floor( t );
+                        index = ( decltype(index) )flr;
+                        t1 = t - flr;
+                    }else
+                    {
+                        index = base_type::sizei - 3;
+                        t1 = t - ( base_type::sizef - 3 );
+                    }
+                    const auto& s = baked_type::segments[ index - 1 ];
+                    return norm( s.b + t1*( 2.0f*s.c + t1*( 3.0f*s.d ) ) );
+                }
+
+            protected:
+                mutable std::vector< float > lengths;
+                mutable std::vector< float > speeds;
+                mutable float dt = 0;
+                mutable std::size_t table_version = 0;
+
+                // 3 point Gauss-Legendre over [ a , b ]
+                float Integrate( float a , float b ) const
+                {
+                    const float h = 0.5f * ( b - a );
+                    const float m = 0.5f * ( b + a );
+                    const float x = 0.7745966692f * h;
+                    return h * ( ( 5.0f/9 ) * Speed( m - x ) + ( 8.0f/9 ) * Speed( m ) + ( 5.0f/9 ) * Speed( m + x ) );
+                }
+
+                void Update() const
+                {
+                    if( table_version == baked_type::version && lengths.empty() == false ){ return; }
+                    table_version = baked_type::version;
+
+                    const std::size_t intervals = std::max< std::size_t >( 1 , ( base_type::sizei - 1 ) * resolution );
+                    dt = ( base_type::sizef - 1 ) / intervals;
+                    lengths.resize( intervals + 1 );
+                    speeds.resize( intervals + 1 );
+                    lengths[ 0 ] = 0;
+                    for( std::size_t j = 0; j < intervals; ++j )
+                    {
+                        lengths[ j + 1 ] = lengths[ j ] + Integrate( j * dt , ( j + 1 ) * dt );
+                        speeds[ j ] = Speed( j * dt );
+                    }
+                    speeds[ intervals ] = Speed( intervals * dt );
+                }
+            };
+        };  // namespace Tween
+    };  // namespace Util
+};  // namespace EH
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+
+#include "Tween.h"
+
+namespace EH
+{
+    namespace Util
+    {
+        namespace Tween
+        {
+            // easing curve sampled at N+1 evenly spaced points of [ 0 , 1 ],
+            // evaluated by linear interpolation between neighbouring entries.
+            // input is clamped to [ 0 , 1 ], so the lookup has no data dependent branch.
+            //
+            //  constexpr auto ease = MakeLookupTable< 64 >( Interpolater< float >( 0.5f ) , 1e-4f );
+            //  float y = ease( t );
+            template < std::size_t N , typename T = float >
+            struct LookupTable
+            {
+                static_assert( N >= 1 , "table needs at least one interval" );
+
+                T data[ N + 1 ];
+
+                // @f : any literal functor with constexpr T operator()( T ) const
+                template < typename F >
+                constexpr static LookupTable Make( const F& f )
+                {
+                    LookupTable ret{};
+                    for( std::size_t i = 0; i <= N; ++i )
+                    {
+                        ret.data[ i ] = f( T( i ) / T( N ) );
+                    }
+                    return ret;
+                }
+
+                constexpr T operator () ( T t ) const
+                {
+                    const T c = t < T(0) ? T(0) : ( t > T(1) ? T(1) : t );
+                    const T x = c * T( N );
+                    const std::size_t xi = static_cast< std::size_t >( x );
+                    // t == 1 lands on the last interval
+                    const std::size_t i = xi < N - 1 ? xi : N - 1;
+                    const T frac = x - T( i );
+                    return data[ i ] + frac * ( data[ i + 1 ] - data[ i ] );
+                }
+
+                void operator () ( const T *t , T *out , std::size_t n ) const
+                {
+                    for( std::size_t i = 0; i < n; ++i )
+                    {
+                        out[ i ] = (*this)( t[ i ] );
+                    }
+                }
+
+                // largest | table(t) - f(t) | over @sub samples per interval
+                template < typename F >
+                constexpr T MaxError( const F& f , std::size_t sub = 8 ) const
+                {
+                    T ret = 0;
+                    for( std::size_t i = 0; i < N * sub; ++i )
+                    {
+                        const T t = ( T( i ) + T( 0.5 ) ) / T( N * sub );
+                        const T e = (*this)( t ) - f( t );
+                        const T ae = e < 0 ? -e : e;
+                        ret = ae > ret ? ae : ret;
+                    }
+                    return ret;
+                }
+            };
+
+            template < std::size_t N , typename T = float , typename F >
+            constexpr LookupTable< N , T > MakeLookupTable( const F& f )
+            {
+                return LookupTable< N , T >::Make( f );
+            }
+
+            // same as above, but refuses tables less accurate than @max_error.
+            // used to initialize a constexpr variable, a violated bound is a compile error.
+            template < std::size_t N , typename T = float , typename F >
+            constexpr LookupTable< N , T > MakeLookupTable( const F& f , T max_error )
+            {
+                return LookupTable< N , T >::Make( f ).MaxError( f ) <= max_error ?
+                    LookupTable< N , T >::Make( f ) :
+                    throw std::logic_error( "lookup table exceeds its error bound, raise N" );
+            }
+        };  // namespace Tween
+    };  // namespace Util
+};  // namespace EH
@@ -0,0 +1,470 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <type_traits>
+#include <utility>
+
+#if defined( __AVX2__ )
+    #include <immintrin.h>
+#elif defined( __SSE4_1__ )
+    #include <smmintrin.h>
+#elif defined( __SSE2__ )
+    #include <emmintrin.h>
+#endif
+
+namespace EH
+{
+    namespace Util
+    {
+        namespace Tween
+        {
+            // batch evaluation kernels for the tweeners in Tween.h
+            //
+            // every kernel is written once against a "Lane" ( ScalarLane , SSELane , AVXLane )
+            // and instantiated for each width, so the vector body and the scalar tail
+            // compute exactly the same formula.
+            namespace SIMD
+            {
+                struct ScalarLane
+                {
+                    using float_type = float;
+                    using int_type   = std::int32_t;
+                    using mask_type  = bool;
+                    constexpr static std::size_t width = 1;
+
+                    static inline float_type load( const float *p ){ return *p; }
+                    static inline void store( float *p , float_type x ){ *p = x; }
+                    static inline float_type set1( float x ){ return x; }
+                    static inline int_type set1i( std::int32_t x ){ return x; }
+
+                    static inline float_type add( float_type a , float_type b ){ return a + b; }
+                    static inline float_type sub( float_type a , float_type b ){ return a - b; }
+                    static inline float_type mul( float_type a , float_type b ){ return a * b; }
+                    static inline int_type addi( int_type a , int_type b ){ return a + b; }
+
+                    static inline float_type floor( float_type x ){ return std::floor( x ); }
+                    static inline int_type to_int( float_type x ){ return static_cast< int_type >( x ); }
+
+                    static inline mask_type less( float_type a , float_type b ){ return a < b; }
+                    static inline float_type select( mask_type m , float_type a , float_type b ){ return m ? a : b; }
+                    static inline int_type selecti( mask_type m , int_type a , int_type b ){ return m ? a : b; }
+
+                    static inline float_type gather( const float *base , int_type index ){ return base[ index ]; }
+                    static inline int_type ramp( std::int32_t start , std::int32_t /*step*/ ){ return start; }
+                };
+
+#if defined( __SSE2__ )
+                struct SSELane
+                {
+                    using float_type = __m128;
+                    using int_type   = __m128i;
+                    using mask_type  = __m128;
+                    constexpr static std::size_t width = 4;
+
+                    static inline float_type load( const float *p ){ return _mm_loadu_ps( p ); }
+                    static inline void store( float *p , float_type x ){ _mm_storeu_ps( p , x ); }
+                    static inline float_type set1( float x ){ return _mm_set1_ps( x ); }
+                    static inline int_type set1i( std::int32_t x ){ return _mm_set1_epi32( x ); }
+
+                    static inline float_type add( float_type a , float_type b ){ return _mm_add_ps( a , b ); }
+                    static inline float_type sub( float_type a , float_type b ){ return _mm_sub_ps( a , b ); }
+                    static inline float_type mul( float_type a , float_type b ){ return _mm_mul_ps( a , b ); }
+                    static inline int_type addi( int_type a , int_type b ){ return _mm_add_epi32( a , b ); }
+
+                    static inline float_type floor( float_type x )
+                    {
+#if defined( __SSE4_1__ )
+                        return _mm_floor_ps( x );
+#else
+                        // truncate, then step down where truncation rounded up ( negative inputs )
+                        const float_type tr = _mm_cvtepi32_ps( _mm_cvttps_epi32( x ) );
+                        return _mm_sub_ps( tr , _mm_and_ps( _mm_cmpgt_ps( tr , x ) , _mm_set1_ps( 1.0f ) ) );
+#endif
+                    }
+                    static inline int_type to_int( float_type x ){ return _mm_cvttps_epi32( x ); }
+
+                    static inline mask_type less( float_type a , float_type b ){ return _mm_cmplt_ps( a , b ); }
+                    static inline float_type select( mask_type m , float_type a , float_type b )
+                    {
+                        return _mm_or_ps( _mm_and_ps( m , a ) , _mm_andnot_ps( m , b ) );
+                    }
+                    static inline int_type selecti( mask_type m , int_type a , int_type b )
+                    {
+                        const int_type mi = _mm_castps_si128( m );
+                        return _mm_or_si128( _mm_and_si128( mi , a ) , _mm_andnot_si128( mi , b ) );
+                    }
+
+                    // no hardware gather before AVX2; spill the indices and load one by one
+                    static inline float_type gather( const float *base , int_type index )
+                    {
+                        alignas( 16 ) std::int32_t i[ 4 ];
+                        _mm_store_si128( reinterpret_cast< __m128i* >( i ) , index );
+                        return _mm_setr_ps( base[ i[0] ] , base[ i[1] ] , base[ i[2] ] , base[ i[3] ] );
+                    }
+                    // { start , start + step , ... }
+                    static inline int_type ramp( std::int32_t start , std::int32_t step )
+                    {
+                        return _mm_setr_epi32( start , start + step , start + 2*step , start + 3*step );
+                    }
+                };
+#endif
+
+#if defined( __AVX2__ )
+                struct AVXLane
+                {
+                    using float_type = __m256;
+                    using int_type   = __m256i;
+                    using mask_type  = __m256;
+                    constexpr static std::size_t width = 8;
+
+                    static inline float_type load( const float *p ){ return _mm256_loadu_ps( p ); }
+                    static inline void store( float *p , float_type x ){ _mm256_storeu_ps( p , x ); }
+                    static inline float_type set1( float x ){ return _mm256_set1_ps( x ); }
+                    static inline int_type set1i( std::int32_t x ){ return _mm256_set1_epi32( x ); }
+
+                    static inline float_type add( float_type a , float_type b ){ return _mm256_add_ps( a , b ); }
+                    static inline float_type sub( float_type a , float_type b ){ return _mm256_sub_ps( a , b ); }
+                    static inline float_type mul( float_type a , float_type b ){ return _mm256_mul_ps( a , b ); }
+                    static inline int_type addi( int_type a , int_type b ){ return _mm256_add_epi32( a , b ); }
+
+                    static inline float_type floor( float_type x ){ return _mm256_floor_ps( x ); }
+                    static inline int_type to_int( float_type x ){ return _mm256_cvttps_epi32( x ); }
+
+                    static inline mask_type less( float_type a , float_type b ){ return _mm256_cmp_ps( a , b , _CMP_LT_OQ ); }
+                    static inline float_type select( mask_type m , float_type a , float_type b )
+                    {
+                        return _mm256_blendv_ps( b , a , m );
+                    }
+                    static inline int_type selecti( mask_type m , int_type a , int_type b )
+                    {
+                        return _mm256_blendv_epi8( b , a , _mm256_castps_si256( m ) );
+                    }
+
+                    static inline float_type gather( const float *base , int_type index )
+                    {
+                        return _mm256_i32gather_ps( base , index , 4 );
+                    }
+                    static inline int_type ramp( std::int32_t start , std::int32_t step )
+                    {
+                        return _mm256_setr_epi32( start , start + step , start + 2*step , start + 3*step ,
+                                start + 4*step , start + 5*step , start + 6*step , start + 7*step );
+                    }
+                };
+#endif
+
+                // Basis policies.
+                // Segment() reproduces the index / local-parameter branches of the scalar tweener,
+                // Weights() gives the per control point weights, starting from container[ index + first ].
+
+                // CubicTweener
+                struct CubicBasis
+                {
+                    constexpr static int first = -1;
+                    constexpr static std::size_t count = 4;
+
+                    template < typename Lane >
+                    static inline void Segment( typename Lane::float_type t , typename Lane::float_type sizef , std::int32_t sizei ,
+                            typename Lane::int_type& index , typename Lane::float_type& t1 )
+                    {
+                        const auto one = Lane::set1( 1.0f );
+                        const auto lo  = Lane::less( t , one );
+                        const auto mid = Lane::less( t , Lane::sub( sizef , Lane::set1( 2.0f ) ) );
+                        const auto flr = Lane::floor( t );
+                        const auto frac = Lane::sub( t , flr );
+
+                        index = Lane::selecti( lo , Lane::set1i( 1 ) , Lane::selecti( mid , Lane::to_int( flr ) , Lane::set1i( sizei - 3 ) ) );
+                        t1    = Lane::select( lo , Lane::sub( t , one ) , Lane::select( mid , frac , Lane::add( frac , one ) ) );
+                    }
+                    template < typename Lane >
+                    static inline void Weights( typename Lane::float_type t1 , typename Lane::float_type (&w)[ 4 ] )
+                    {
+                        const auto t2 = Lane::mul( t1 , t1 );
+                        const auto t3 = Lane::mul( t2 , t1 );
+                        const auto half  = Lane::set1( 0.5f );
+                        const auto sixth = Lane::set1( 1.0f / 6.0f );
+                        const auto third = Lane::set1( 1.0f / 3.0f );
+                        const auto zero  = Lane::set1( 0.0f );
+
+                        //  - t3/6 + t2/2 + t1/3
+                        w[0] = Lane::add( Lane::add( Lane::sub( zero , Lane::mul( t3 , sixth ) ) , Lane::mul( t2 , half ) ) , Lane::mul( t1 , third ) );
+                        //  - t3/2 - t2 - t1/2 + 1
+                        w[1] = Lane::add( Lane::sub( Lane::sub( Lane::sub( zero , Lane::mul( t3 , half ) ) , t2 ) , Lane::mul( t1 , half ) ) , Lane::set1( 1.0f ) );
+                        //  - t3/2 + t2/2 + t1
+                        w[2] = Lane::add( Lane::add( Lane::sub( zero , Lane::mul( t3 , half ) ) , Lane::mul( t2 , half ) ) , t1 );
+                        //    t3/6 - t1/6
+                        w[3] = Lane::sub( Lane::mul( t3 , sixth ) , Lane::mul( t1 , sixth ) );
+                    }
+                };
+
+                // MonotoneCubicTweener
+                struct MonotoneCubicBasis
+                {
+                    constexpr static int first = -1;
+                    constexpr static std::size_t count = 3;
+
+                    template < typename Lane >
+                    static inline void Segment( typename Lane::float_type t , typename Lane::float_type sizef , std::int32_t sizei ,
+                            typename Lane::int_type& index , typename Lane::float_type& t1 )
+                    {
+                        const auto half = Lane::set1( 0.5f );
+                        const auto lo = Lane::less( t , half );
+                        const auto hi = Lane::less( Lane::sub( sizef , Lane::set1( 1.5f ) ) , t );
+                        // std::round == floor( t + 0.5 ) on the middle branch, where t >= 0.5
+                        const auto rt = Lane::floor( Lane::add( t , half ) );
+
+                        index = Lane::selecti( lo , Lane::set1i( 1 ) , Lane::selecti( hi , Lane::set1i( sizei - 2 ) , Lane::to_int( rt ) ) );
+                        t1    = Lane::select( lo , Lane::sub( t , Lane::set1( 1.0f ) ) ,
+                                Lane::select( hi , Lane::sub( t , Lane::sub( sizef , Lane::set1( 2.0f ) ) ) , Lane::sub( t , rt ) ) );
+                    }
+                    template < typename Lane >
+                    static inline void Weights( typename Lane::float_type t1 , typename Lane::float_type (&w)[ 3 ] )
+                    {
+                        const auto half = Lane::set1( 0.5f );
+                        const auto t2h = Lane::mul( Lane::mul( t1 , t1 ) , half );
+                        const auto t1h = Lane::mul( t1 , half );
+
+                        //    t2/2 - t1/2
+                        w[0] = Lane::sub( t2h , t1h );
+                        //  - t2 + 1
+                        w[1] = Lane::add( Lane::sub( Lane::set1( 0.0f ) , Lane::mul( t1 , t1 ) ) , Lane::set1( 1.0f ) );
+                        //    t2/2 + t1/2
+                        w[2] = Lane::add( t2h , t1h );
+                    }
+                };
+
+                // MonotoneSquareTweener
+                // the tangent terms m0 , m1 are folded into the four point weights
+                struct MonotoneSquareBasis
+                {
+                    constexpr static int first = -1;
+                    constexpr static std::size_t count = 4;
+
+                    template < typename Lane >
+                    static inline void Segment( typename Lane::float_type t , typename Lane::float_type sizef , std::int32_t sizei ,
+                            typename Lane::int_type& index , typename Lane::float_type& t1 )
+                    {
+                        const auto half = Lane::set1( 0.5f );
+                        const auto lo  = Lane::less( t , Lane::set1( 1.5f ) );
+                        const auto end = Lane::sub( sizef , Lane::set1( 2.5f ) );
+                        const auto mid = Lane::less( t , end );
+                        const auto fl  = Lane::floor( t );
+
+                        index = Lane::selecti( lo , Lane::set1i( 1 ) , Lane::selecti( mid , Lane::to_int( fl ) , Lane::set1i( sizei - 3 ) ) );
+                        t1    = Lane::select( lo , Lane::sub( t , Lane::set1( 1.5f ) ) ,
+                                Lane::select( mid , Lane::sub( t , Lane::add( fl , half ) ) , Lane::sub( t , end ) ) );
+                    }
+                    template < typename Lane >
+                    static inline void Weights( typename Lane::float_type t1 , typename Lane::float_type (&w)[ 4 ] )
+                    {
+                        const auto half    = Lane::set1( 0.5f );
+                        const auto quarter = Lane::set1( 0.25f );
+                        const auto onehalf = Lane::set1( 1.5f );
+                        const auto t2 = Lane::mul( t1 , t1 );
+                        const auto t3 = Lane::mul( t2 , t1 );
+                        const auto t3x2 = Lane::mul( t3 , Lane::set1( 2.0f ) );
+
+                        // 2t3 - 1.5t1 + 0.5
+                        const auto h0 = Lane::add( Lane::sub( t3x2 , Lane::mul( onehalf , t1 ) ) , half );
+                        // -2t3 + 1.5t1 + 0.5
+                        const auto h1 = Lane::add( Lane::add( Lane::sub( Lane::set1( 0.0f ) , t3x2 ) , Lane::mul( onehalf , t1 ) ) , half );
+                        // t3 - 0.5t2 - 0.25t1 + 0.25
+                        const auto hm0 = Lane::add( Lane::sub( Lane::sub( t3 , Lane::mul( half , t2 ) ) , Lane::mul( quarter , t1 ) ) , quarter );
+                        // t3 + 0.5t2 - 0.25t1 - 0.25
+                        const auto hm1 = Lane::sub( Lane::sub( Lane::add( t3 , Lane::mul( half , t2 ) ) , Lane::mul( quarter , t1 ) ) , quarter );
+
+                        const auto m0h = Lane::mul( hm0 , half );
+                        const auto m1h = Lane::mul( hm1 , half );
+                        w[0] = m0h;
+                        w[1] = h0;
+                        w[2] = Lane::add( h1 , Lane::add( m0h , m1h ) );
+                        w[3] = m1h;
+                    }
+                };
+
+                // evaluate one lane-width of samples from a single contiguous float channel
+                template < typename Basis , typename Lane >
+                inline typename Lane::float_type Sample( const float *points , typename Lane::float_type t ,
+                        typename Lane::float_type sizef , std::int32_t sizei )
+                {
+                    typename Lane::int_type index;
+                    typename Lane::float_type t1;
+                    typename Lane::float_type w[ Basis::count ];
+
+                    Basis::template Segment< Lane >( t , sizef , sizei , index , t1 );
+                    Basis::template Weights< Lane >( t1 , w );
+
+                    const float *base = points + Basis::first;
+                    typename Lane::float_type ret = Lane::mul( w[0] , Lane::gather( base , index ) );
+                    for( std::size_t k = 1; k < Basis::count; ++k )
+                    {
+                        ret = Lane::add( ret , Lane::mul( w[k] , Lane::gather( base + k , index ) ) );
+                    }
+                    return ret;
+                }
+
+                // process [ i , n ) in steps of Lane::width, returns the first unprocessed index
+                template < typename Basis , typename Lane >
+                inline std::size_t Run( const float *points , float sizef , std::size_t sizei ,
+                        const float *t , float *out , std::size_t i , std::size_t n )
+                {
+                    const auto sizefv = Lane::set1( sizef );
+                    const std::int32_t sizeiv = static_cast< std::int32_t >( sizei );
+                    for( ; i + Lane::width <= n; i += Lane::width )
+                    {
+                        Lane::store( out + i , Sample< Basis , Lane >( points , Lane::load( t + i ) , sizefv , sizeiv ) );
+                    }
+                    return i;
+                }
+
+                // out[ i ] = tweener( t[ i ] ) for i in [ 0 , n ),
+                // with the widest kernel the target supports and a scalar tail.
+                // results agree with the scalar tweeners to a few ulp.
+                template < typename Basis >
+                void Evaluate( const float *points , float sizef , std::size_t sizei ,
+                        const float *t , float *out , std::size_t n )
+                {
+                    std::size_t i = 0;
+#if defined( __AVX2__ )
+                    i = Run< Basis , AVXLane >( points , sizef , sizei , t , out , i , n );
+#endif
+#if defined( __SSE2__ )
+                    i = Run< Basis , SSELane >( points , sizef , sizei , t , out , i , n );
+#endif
+                    Run< Basis , ScalarLane >( points , sizef , sizei , t , out , i , n );
+                }
+
+                // Multi channel ( structure of arrays ) evaluation.
+                // channel c's control points are points[ c*stride , c*stride + sizei ),
+                // the segment and weights are computed once and shared by every channel.
+
+                // one sample, lanes run across channels
+                template < typename Basis , typename Lane >
+                inline std::size_t RunChannels( const float *points , std::size_t stride , std::int32_t index ,
+                        const float (&w)[ Basis::count ] , float *out , std::size_t c , std::size_t channels )
+                {
+                    const float *base = points + Basis::first;
+                    for( ; c + Lane::width <= channels; c += Lane::width )
+                    {
+                        const auto idx = Lane::ramp( static_cast< std::int32_t >( c*stride ) + index , static_cast< std::int32_t >( stride ) );
+                        typename Lane::float_type ret = Lane::mul( Lane::set1( w[0] ) , Lane::gather( base , idx ) );
+                        for( std::size_t k = 1; k < Basis::count; ++k )
+                        {
+                            ret = Lane::add( ret , Lane::mul( Lane::set1( w[k] ) , Lane::gather( base + k , idx ) ) );
+                        }
+                        Lane::store( out + c , ret );
+                    }
+                    return c;
+                }
+                // out[ c ] = channel c at t
+                template < typename Basis >
+                void EvaluateChannels( const float *points , std::size_t stride , std::size_t channels ,
+                        float sizef , std::size_t sizei , float t , float *out )
+                {
+                    std::int32_t index;
+                    float t1;
+                    float w[ Basis::count ];
+                    Basis::template Segment< ScalarLane >( t , sizef , static_cast< std::int32_t >( sizei ) , index , t1 );
+                    Basis::template Weights< ScalarLane >( t1 , w );
+
+                    std::size_t c = 0;
+#if defined( __AVX2__ )
+                    c = RunChannels< Basis , AVXLane >( points , stride , index , w , out , c , channels );
+#endif
+#if defined( __SSE2__ )
+                    c = RunChannels< Basis , SSELane >( points , stride , index , w , out , c , channels );
+#endif
+                    RunChannels< Basis , ScalarLane >( points , stride , index , w , out , c , channels );
+                }
+
+                // many samples, lanes run across samples; each block of samples
+                // looks up its segments once and reuses them for every channel
+                template < typename Basis , typename Lane >
+                inline std::size_t RunBatchChannels( const float *points , std::size_t stride , std::size_t channels ,
+                        float sizef , std::size_t sizei , const float *t , float *out , std::size_t out_stride ,
+                        std::size_t i , std::size_t n )
+                {
+                    const auto sizefv = Lane::set1( sizef );
+                    const std::int32_t sizeiv = static_cast< std::int32_t >( sizei );
+                    for( ; i + Lane::width <= n; i += Lane::width )
+                    {
+                        typename Lane::int_type index;
+                        typename Lane::float_type t1;
+                        typename Lane::float_type w[ Basis::count ];
+                        Basis::template Segment< Lane >( Lane::load( t + i ) , sizefv , sizeiv , index , t1 );
+                        Basis::template Weights< Lane >( t1 , w );
+
+                        for( std::size_t c = 0; c < channels; ++c )
+                        {
+                            const float *base = points + c*stride + Basis::first;
+                            typename Lane::float_type ret = Lane::mul( w[0] , Lane::gather( base , index ) );
+                            for( std::size_t k = 1; k < Basis::count; ++k )
+                            {
+                                ret = Lane::add( ret , Lane::mul( w[k] , Lane::gather( base + k , index ) ) );
+                            }
+                            Lane::store( out + c*out_stride + i , ret );
+                        }
+                    }
+                    return i;
+                }
+                // out[ c*out_stride + i ] = channel c at t[ i ]
+                template < typename Basis >
+                void EvaluateChannels( const float *points , std::size_t stride , std::size_t channels ,
+                        float sizef , std::size_t sizei , const float *t , float *out , std::size_t out_stride , std::size_t n )
+                {
+                    std::size_t i = 0;
+#if defined( __AVX2__ )
+                    i = RunBatchChannels< Basis , AVXLane >( points , stride , channels , sizef , sizei , t , out , out_stride , i , n );
+#endif
+#if defined( __SSE2__ )
+                    i = RunBatchChannels< Basis , SSELane >( points , stride , channels , sizef , sizei , t , out , out_stride , i , n );
+#endif
+                    RunBatchChannels< Basis , ScalarLane >( points , stride , channels , sizef , sizei , t , out , out_stride , i , n );
+                }
+
+                // true if the container is float storage reachable through a pointer
+                template < typename Container , typename = void >
+                struct is_contiguous_float : std::false_type
+                {
+                };
+                template < typename Container >
+                struct is_contiguous_float< Container ,
+                    typename std::enable_if<
+                        std::is_same<
+                            typename std::remove_cv<
+                                typename std::remove_pointer< decltype( std::declval< const Container& >().data() ) >::type
+                            >::type ,
+                            float
+                        >::value
+                    >::type > : std::true_type
+                {
+                };
+
+                // vectorized path : T is float and the control points are contiguous
+                template < typename Basis , typename Tweener >
+                inline void Batch( Tweener& tweener , const float *t , float *out , std::size_t n , std::true_type )
+                {
+                    Evaluate< Basis >( tweener.container.data() , tweener.sizef , tweener.sizei , t , out , n );
+                }
+                // fallback : anything else goes through the scalar operator()
+                template < typename Basis , typename Tweener , typename T >
+                inline void Batch( Tweener& tweener , const float *t , T *out , std::size_t n , std::false_type )
+                {
+                    for( std::size_t i = 0; i < n; ++i )
+                    {
+                        out[ i ] = tweener( t[ i ] );
+                    }
+                }
+                template < typename Basis , typename Tweener , typename T >
+                inline void Batch( Tweener& tweener , const float *t , T *out , std::size_t n )
+                {
+                    using container_type = decltype( tweener.container );
+                    Batch< Basis >( tweener , t , out , n ,
+                            std::integral_constant< bool ,
+                                std::is_same< T , float >::value && is_contiguous_float< container_type >::value >() );
+                }
+            };  // namespace SIMD
+        };  // namespace Tween
+    };  // namespace Util
+};  // namespace EH
@@ -0,0 +1,68 @@
+// compresses files into the "EHLZ" container read by EH::File::LoadBinary
+//
+//  ehlz [-b block_size] input output
+//  ehlz -d input output
+
+#include "EHFile.h"
+
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+    int Usage()
+    {
+        std::cerr << "usage : ehlz [-b block_size] input output\n"
+                  << "        ehlz -d input output\n";
+        return 1;
+    }
+
+    bool Save( const char *name , const char *data , std::size_t size )
+    {
+        std::ofstream out( name , std::ios_base::out | std::ios_base::binary | std::ios_base::trunc );
+        out.write( data , size );
+        return static_cast< bool >( out );
+    }
+};
+
+int main( int argc , char **argv )
+{
+    std::uint32_t block_size = 1 << 18;
+    bool decode = false;
+    int i = 1;
+    for( ; i < argc && argv[ i ][ 0 ] == '-'; ++i )
+    {
+        if( std::strcmp( argv[ i ] , "-d" ) == 0 )
+        {
+            decode = true;
+        }else if( std::strcmp( argv[ i ] , "-b" ) == 0 && i + 1 < argc )
+        {
+            block_size = static_cast< std::uint32_t >( std::strtoul( argv[ ++i ] , 0 , 10 ) );
+        }else
+        {
+            return Usage();
+        }
+    }
+    if( argc - i != 2 ){ return Usage(); }
+
+    if( decode )
+    {
+        std::size_t size;
+        auto data = EH::File::LoadBinary( argv[ i ] , size );
+        if( data.data() == 0 ){ return 1; }
+        return Save( argv[ i + 1 ] , data.data() , size ) ? 0 : 1;
+    }
+
+    EH::File::MappedFile in = EH::File::MapFile( argv[ i ] , EH::File::Access::Sequential );
+    if( !in ){ return 1; }
+    const std::vector< char > packed = EH::LZ::Compress( in.data() , in.size() , block_size );
+    if( packed.empty() )
+    {
+        std::cerr << argv[ i ] << " : too many blocks , use a larger -b\n";
+        return 1;
+    }
+    std::cerr << in.size() << " -> " << packed.size() << " bytes\n";
+    return Save( argv[ i + 1 ] , packed.data() , packed.size() ) ? 0 : 1;
+}
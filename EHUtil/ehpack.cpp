@@ -0,0 +1,67 @@
+// builds and lists EH::File pack archives
+//
+//  ehpack [-a alignment] [-C dir] output.pack file...
+//  ehpack -l input.pack
+//
+// files are stored under the path given on the command line, relative to -C if set
+
+#include "Pack.h"
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+    int Usage()
+    {
+        std::cerr << "usage : ehpack [-a alignment] [-C dir] output.pack file...\n"
+                  << "        ehpack -l input.pack\n";
+        return 1;
+    }
+
+    int List( const char *name )
+    {
+        EH::File::PackFile pack( name );
+        if( !pack ){ return 1; }
+        for( std::size_t i = 0; i < pack.Size(); ++i )
+        {
+            const auto view = pack.At( i );
+            std::cout << view.size << '\t' << ( view.data - pack.Mapping().data() ) << '\t' << pack.Name( i ) << '\n';
+        }
+        return 0;
+    }
+};
+
+int main( int argc , char **argv )
+{
+    std::uint32_t alignment = 64;
+    std::string dir;
+    int i = 1;
+    for( ; i < argc && argv[ i ][ 0 ] == '-'; ++i )
+    {
+        if( std::strcmp( argv[ i ] , "-l" ) == 0 && i + 1 < argc )
+        {
+            return List( argv[ i + 1 ] );
+        }else if( std::strcmp( argv[ i ] , "-a" ) == 0 && i + 1 < argc )
+        {
+            alignment = static_cast< std::uint32_t >( std::strtoul( argv[ ++i ] , 0 , 10 ) );
+        }else if( std::strcmp( argv[ i ] , "-C" ) == 0 && i + 1 < argc )
+        {
+            dir = std::string( argv[ ++i ] ) + "/";
+        }else
+        {
+            return Usage();
+        }
+    }
+    if( argc - i < 2 ){ return Usage(); }
+
+    const char *output = argv[ i++ ];
+    EH::File::PackBuilder builder( alignment );
+    for( ; i < argc; ++i )
+    {
+        builder.Add( argv[ i ] , dir + argv[ i ] );
+    }
+    return builder.Write( output ) ? 0 : 1;
+}
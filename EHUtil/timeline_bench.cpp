@@ -0,0 +1,62 @@
+// times Timeline::Update over thread pools of 0 .. N workers
+//
+//  timeline_bench [tweens] [frames] [max_threads]
+
+#include "Timeline.h"
+
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+
+namespace
+{
+    typedef EH::Util::Tween::Timeline< float > timeline_type;
+
+    void Fill( timeline_type& timeline , std::vector< float >& targets )
+    {
+        for( std::size_t i = 0; i < targets.size(); ++i )
+        {
+            // long enough that nothing retires during the run
+            timeline.Add( 0.0f , 1.0f , 1e6f , EH::Util::Tween::Interpolater< float >( ( i % 7 ) * 0.1f ) , &targets[ i ] );
+        }
+    }
+
+    // milliseconds per frame
+    template < typename F >
+    double Time( std::size_t frames , F update )
+    {
+        update();
+        const auto start = std::chrono::steady_clock::now();
+        for( std::size_t i = 0; i < frames; ++i )
+        {
+            update();
+        }
+        const std::chrono::duration< double , std::milli > elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / frames;
+    }
+};
+
+int main( int argc , char **argv )
+{
+    const std::size_t tweens = argc > 1 ? std::strtoul( argv[ 1 ] , 0 , 10 ) : 1 << 20;
+    const std::size_t frames = argc > 2 ? std::strtoul( argv[ 2 ] , 0 , 10 ) : 100;
+    const std::size_t max_threads = argc > 3 ? std::strtoul( argv[ 3 ] , 0 , 10 ) :
+                                    std::max< std::size_t >( std::thread::hardware_concurrency() , 1 );
+
+    std::vector< float > targets( tweens );
+    timeline_type timeline;
+    Fill( timeline , targets );
+
+    const double serial = Time( frames , [ & ](){ timeline.Update( 1.0f / 60 ); } );
+    std::cout << tweens << " tweens , " << std::thread::hardware_concurrency() << " hardware threads\n"
+              << "serial      " << serial << " ms\n";
+
+    for( std::size_t threads = 0; threads <= max_threads; ++threads )
+    {
+        EH::ThreadPool pool( threads );
+        const double ms = Time( frames , [ & ](){ timeline.Update( 1.0f / 60 , pool ); } );
+        std::cout << "workers " << threads << "   " << ms << " ms , x" << serial / ms << "\n";
+    }
+    return 0;
+}
@@ -3,4 +3,9 @@
 #include "json/global.hpp"
 #include "json/json.hpp"
 #include "json/stream_functions.hpp"
-#include "json/grammar.hpp"
+#include "json/parser.hpp"
+#include "json/document.hpp"
+#include "json/events.hpp"
+#include "json/lazy.hpp"
+#include "json/path.hpp"
+#include "json/writer.hpp"
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+namespace eh { namespace json {
+
+// bump allocator made of heap blocks.
+// deallocation is a no-op; everything is released at once with the arena.
+//
+// every live arena has a small id, so a 16 byte JsonData node can record
+// which arena it belongs to ( id 0 : the heap ).
+class arena
+{
+public:
+  static constexpr std::uint32_t max_arenas = 4096;
+
+  explicit arena( std::size_t block_size = 64 << 10 ) :
+    block_size_( block_size ) ,
+    current_( 0 ) ,
+    id_( 0 )
+  {
+    std::lock_guard< std::mutex > lock( table_mutex() );
+    for( std::uint32_t i = 1; i < max_arenas; ++i )
+    {
+      if( table()[ i ].load( std::memory_order_relaxed ) == nullptr )
+      {
+        table()[ i ].store( this , std::memory_order_release );
+        id_ = i;
+        break;
+      }
+    }
+  }
+  ~arena()
+  {
+    if( id_ )
+    {
+      std::lock_guard< std::mutex > lock( table_mutex() );
+      table()[ id_ ].store( nullptr , std::memory_order_release );
+    }
+  }
+  arena( const arena& ) = delete;
+  arena& operator = ( const arena& ) = delete;
+
+  void* allocate( std::size_t n , std::size_t align )
+  {
+    while( current_ < blocks_.size() )
+    {
+      if( void *p = blocks_[ current_ ].allocate( n , align ) ){ return p; }
+      ++current_;
+    }
+    // blocks double up to 128 x block_size , so large documents need few of them
+    const std::size_t grown = block_size_ << ( blocks_.size() < 7 ? blocks_.size() : 7 );
+    blocks_.emplace_back( n + align > grown ? n + align : grown );
+    current_ = blocks_.size() - 1;
+    return blocks_.back().allocate( n , align );
+  }
+
+  // forget every allocation , the blocks are kept for reuse
+  void clear()
+  {
+    for( auto& b : blocks_ ){ b.pos = 0; }
+    current_ = 0;
+  }
+
+  // bytes handed out / bytes reserved
+  std::size_t used() const
+  {
+    std::size_t n = 0;
+    for( auto& b : blocks_ ){ n += b.pos; }
+    return n;
+  }
+  std::size_t reserved() const
+  {
+    std::size_t n = 0;
+    for( auto& b : blocks_ ){ n += b.size; }
+    return n;
+  }
+
+  // 0 if every id was taken; nodes of such an arena fall back to the heap
+  std::uint32_t id() const
+  {
+    return id_;
+  }
+  static arena* find( std::uint32_t id )
+  {
+    return id ? table()[ id ].load( std::memory_order_acquire ) : nullptr;
+  }
+
+protected:
+  // one block from operator new , handed out front to back
+  struct block
+  {
+    char *memory;
+    std::size_t size;
+    std::size_t pos;
+
+    explicit block( std::size_t n ) :
+      memory( static_cast< char* >( ::operator new( n ) ) ) ,
+      size( n ) ,
+      pos( 0 )
+    {
+    }
+    block( block&& rhs ) noexcept :
+      memory( rhs.memory ) ,
+      size( rhs.size ) ,
+      pos( rhs.pos )
+    {
+      rhs.memory = nullptr;
+    }
+    block( const block& ) = delete;
+    block& operator = ( const block& ) = delete;
+    ~block()
+    {
+      ::operator delete( memory );
+    }
+
+    // null once the block is full. @align : a power of two
+    void* allocate( std::size_t n , std::size_t align )
+    {
+      const std::uintptr_t base = reinterpret_cast< std::uintptr_t >( memory );
+      const std::size_t start = ( ( base + pos + align - 1 ) & ~std::uintptr_t( align - 1 ) ) - base;
+      if( start + n > size ){ return nullptr; }
+      pos = start + n;
+      return memory + start;
+    }
+  };
+
+  std::vector< block > blocks_;
+  std::size_t block_size_;
+  std::size_t current_;
+  std::uint32_t id_;
+
+  static std::atomic< arena* >* table()
+  {
+    static std::atomic< arena* > t[ max_arenas ] = {};
+    return t;
+  }
+  static std::mutex& table_mutex()
+  {
+    static std::mutex m;
+    return m;
+  }
+};
+
+// std allocator over an arena , or over the heap when the arena is null.
+// copies of a container are made on the heap ( select_on_container_copy_construction ),
+// so values copied out of a document do not depend on it.
+template < typename T >
+class arena_allocator
+{
+public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::false_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  arena_allocator() noexcept :
+    arena_( nullptr )
+  {
+  }
+  explicit arena_allocator( arena *a ) noexcept :
+    arena_( a )
+  {
+  }
+  template < typename U >
+  arena_allocator( const arena_allocator< U >& rhs ) noexcept :
+    arena_( rhs.get_arena() )
+  {
+  }
+
+  T* allocate( std::size_t n )
+  {
+    if( arena_ )
+    {
+      return static_cast< T* >( arena_->allocate( n * sizeof( T ) , alignof( T ) ) );
+    }
+    return static_cast< T* >( ::operator new( n * sizeof( T ) ) );
+  }
+  void deallocate( T *p , std::size_t )
+  {
+    if( arena_ == nullptr )
+    {
+      ::operator delete( p );
+    }
+  }
+
+  arena_allocator select_on_container_copy_construction() const
+  {
+    return arena_allocator();
+  }
+
+  arena* get_arena() const
+  {
+    return arena_;
+  }
+  std::uint32_t arena_id() const
+  {
+    return arena_ ? arena_->id() : 0;
+  }
+
+protected:
+  arena *arena_;
+};
+template < typename T , typename U >
+bool operator == ( const arena_allocator< T >& a , const arena_allocator< U >& b )
+{
+  return a.get_arena() == b.get_arena();
+}
+template < typename T , typename U >
+bool operator != ( const arena_allocator< T >& a , const arena_allocator< U >& b )
+{
+  return a.get_arena() != b.get_arena();
+}
+
+}}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "parser.hpp"
+
+#include <memory>
+
+namespace eh { namespace json {
+
+// a parsed value together with the arena its tree lives in.
+//
+// nodes , strings and containers all come from the arena , so parsing does
+// no general purpose allocation once the arena has grown , and dropping the
+// tree is a single release. values assigned through root()[ ... ] are
+// copied into the arena as well.
+//
+// lifetime : references into the tree stay valid until the next parse() ,
+// clear() or the destruction of the document. copy a value ( JsonData copy
+// constructor ) to keep it longer; a value moved out still points into the arena.
+//
+// parse_in_situ() additionally leaves string values without escapes inside
+// the caller's buffer ( a mapped file ... ): that buffer has to stay alive and
+// unchanged for as long as the tree is used. strings with escapes are decoded
+// into the arena. getString() detaches such a string by writing its node , even
+// through a const reference : threads sharing the tree use getStringView().
+//
+//  document doc;
+//  if( doc.parse( text.begin() , text.end() ) )
+//  {
+//    doc.root()[ "seen" ] = true;
+//  }
+class document
+{
+public:
+  explicit document( std::size_t block_size = 64 << 10 ) :
+    arena_( new arena( block_size ) ) ,
+    root_( std::allocator_arg , JsonData::allocator_type( arena_.get() ) )
+  {
+  }
+  document( document&& ) = default;
+  document& operator = ( document&& ) = delete;
+  document( const document& ) = delete;
+  document& operator = ( const document& ) = delete;
+
+  JsonData& root()
+  {
+    return root_;
+  }
+  const JsonData& root() const
+  {
+    return root_;
+  }
+
+  // replaces the tree; on failure the root is null
+  template < typename IterType >
+  bool parse( IterType begin , IterType end )
+  {
+    clear();
+    std::size_t consumed;
+    return parser::parse_range( begin , end , root_ , consumed , index_ , parser::is_contiguous< IterType >() );
+  }
+
+  // zero copy strings , see the lifetime contract above
+  bool parse_in_situ( const char *begin , const char *end )
+  {
+    clear();
+    std::size_t consumed;
+    return parser::parse_buffer( begin , end - begin , root_ , consumed , index_ , true );
+  }
+
+  // drops the tree , keeping the arena blocks for the next parse()
+  void clear()
+  {
+    root_.reset();
+    arena_->clear();
+  }
+
+  // bytes held by the arena
+  std::size_t memory() const
+  {
+    return arena_->reserved();
+  }
+
+protected:
+  // declared first , so the tree never outlives it
+  std::unique_ptr< arena > arena_;
+  JsonData root_;
+  std::vector< std::uint32_t > index_;
+};
+
+}}
@@ -0,0 +1,392 @@
+#pragma once
+
+#include "parser.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+namespace eh { namespace json {
+
+// no-op handler to derive from; the parser calls the methods by name ,
+// so a handler only defines the events it cares about.
+// returning false stops the parse.
+struct event_handler
+{
+  bool start_object() { return true; }
+  bool end_object() { return true; }
+  bool start_array() { return true; }
+  bool end_array() { return true; }
+  // @str is only valid during the call
+  bool key( std::string_view ) { return true; }
+  bool string( std::string_view ) { return true; }
+  bool number( json_number_t ) { return true; }
+  bool boolean( json_bool_t ) { return true; }
+  bool null() { return true; }
+};
+
+// push parser : feed() the input in chunks of any size , events go to the
+// handler as soon as each token is complete.
+//
+// memory is bounded : a depth stack of @max_depth and one buffer of at most
+// @max_token bytes for a token that straddles two chunks; a longer split token
+// fails the parse. strings lying inside a chunk are passed to the handler
+// without copying , only those with escapes are decoded into a scratch string.
+// the input may hold several top level values one after another ( JSON lines ).
+//
+// unlike parse() , which reads a missing value as null ( "[1,,2]" , "{"a":}" ,
+// "[1,]" ), this parser rejects them.
+//
+//  struct counter : event_handler
+//  {
+//    long n = 0;
+//    bool number( json_number_t ){ ++n; return true; }
+//  } c;
+//  event_parser< counter > parser( c );
+//  for( auto chunk = reader.Next(); chunk.size; chunk = reader.Next() )
+//  {
+//    parser.feed( chunk.data , chunk.size );
+//  }
+//  parser.finish();
+template < typename Handler >
+class event_parser
+{
+public:
+  explicit event_parser( Handler& handler , std::size_t max_depth = 1024 ,
+                         std::size_t max_token = std::size_t( 16 ) << 20 ) :
+    handler_( handler ) ,
+    max_depth_( max_depth ) ,
+    max_token_( max_token )
+  {
+    stack_.reserve( max_depth );
+    reset();
+  }
+
+  // false on a syntax error or when the handler stopped the parse ,
+  // every later call fails as well
+  bool feed( const char *data , std::size_t size )
+  {
+    if( failed_ )
+    {
+      return false;
+    }
+    const char *p = data;
+    const char *end = data + size;
+    while( p != end )
+    {
+      if( state_ == state::in_string )
+      {
+        p = continue_string( p , end );
+      }else if( state_ == state::in_scalar )
+      {
+        p = continue_scalar( p , end );
+      }else
+      {
+        while( p != end && is_space( *p ) ){ ++p; }
+        if( p == end ){ break; }
+        p = token( p , end );
+      }
+      if( p == nullptr )
+      {
+        failed_ = true;
+        return false;
+      }
+      error_offset_ = offset_ + ( p - data );
+    }
+    offset_ += size;
+    error_offset_ = offset_;
+    return true;
+  }
+  bool feed( std::string_view chunk )
+  {
+    return feed( chunk.data() , chunk.size() );
+  }
+
+  // end of input : completes a trailing number or literal. false if the
+  // input stopped inside a value
+  bool finish()
+  {
+    if( failed_ )
+    {
+      return false;
+    }
+    if( state_ == state::in_scalar )
+    {
+      state_ = state::between;
+      if( scalar( token_.data() , token_.data() + token_.size() ) == false )
+      {
+        failed_ = true;
+        return false;
+      }
+    }
+    return state_ == state::between && stack_.empty() && expect_ == expect::value;
+  }
+
+  // ready for a new input
+  void reset()
+  {
+    stack_.clear();
+    token_.clear();
+    state_ = state::between;
+    expect_ = expect::value;
+    escape_pending_ = false;
+    key_ = false;
+    failed_ = false;
+    offset_ = 0;
+    error_offset_ = 0;
+  }
+
+  explicit operator bool () const
+  {
+    return failed_ == false;
+  }
+  // bytes fed so far; after a failure , roughly where it happened
+  std::size_t offset() const
+  {
+    return failed_ ? error_offset_ : offset_;
+  }
+  std::size_t depth() const
+  {
+    return stack_.size();
+  }
+
+protected:
+  enum class state { between , in_string , in_scalar };
+  // what the grammar allows next
+  enum class expect { value , value_or_end , key , key_or_end , colon , comma_or_end };
+
+  Handler& handler_;
+  std::size_t max_depth_;
+  std::size_t max_token_;
+  // true : object , false : array
+  std::vector< bool > stack_;
+  // a token split across chunks : raw string bytes from the opening quote ,
+  // or a number / literal
+  std::string token_;
+  // decoded string with escapes
+  std::string decoded_;
+  state state_;
+  expect expect_;
+  // the raw string ends in an unpaired backslash
+  bool escape_pending_;
+  // the string being read is an object key
+  bool key_;
+  bool failed_;
+  std::size_t offset_;
+  std::size_t error_offset_;
+
+  static bool is_space( char c )
+  {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+  }
+
+  // a token starting at @p , returns the position after it ( or end ), null on error
+  const char* token( const char *p , const char *end )
+  {
+    const char c = *p;
+    switch( expect_ )
+    {
+    case expect::colon:
+      if( c != ':' ){ return nullptr; }
+      expect_ = expect::value;
+      return p + 1;
+    case expect::comma_or_end:
+      if( c == ',' )
+      {
+        expect_ = stack_.back() ? expect::key : expect::value;
+        return p + 1;
+      }
+      return close( c ) ? p + 1 : nullptr;
+    case expect::key_or_end:
+      if( c == '}' ){ return close( c ) ? p + 1 : nullptr; }
+      // fall through
+    case expect::key:
+      if( c != '"' ){ return nullptr; }
+      key_ = true;
+      return string( p , end );
+    case expect::value_or_end:
+      if( c == ']' ){ return close( c ) ? p + 1 : nullptr; }
+      // fall through
+    case expect::value:
+      break;
+    }
+
+    switch( c )
+    {
+    case '{':
+      if( stack_.size() == max_depth_ || handler_.start_object() == false ){ return nullptr; }
+      stack_.push_back( true );
+      expect_ = expect::key_or_end;
+      return p + 1;
+    case '[':
+      if( stack_.size() == max_depth_ || handler_.start_array() == false ){ return nullptr; }
+      stack_.push_back( false );
+      expect_ = expect::value_or_end;
+      return p + 1;
+    case '"':
+      key_ = false;
+      return string( p , end );
+    case ',': case ':': case '}': case ']':
+      return nullptr;
+    default:
+      {
+        const char *q = p;
+        while( q != end && parser::is_delimiter( *q ) == false ){ ++q; }
+        if( q == end )
+        {
+          if( static_cast< std::size_t >( end - p ) > max_token_ ){ return nullptr; }
+          token_.assign( p , end );
+          state_ = state::in_scalar;
+          return end;
+        }
+        return scalar( p , q ) ? q : nullptr;
+      }
+    }
+  }
+
+  // '}' or ']' closing the innermost container
+  bool close( char c )
+  {
+    if( stack_.empty() || c != ( stack_.back() ? '}' : ']' ) ){ return false; }
+    const bool object = stack_.back();
+    stack_.pop_back();
+    if( ( object ? handler_.end_object() : handler_.end_array() ) == false ){ return false; }
+    value_done();
+    return true;
+  }
+
+  void value_done()
+  {
+    expect_ = stack_.empty() ? expect::value : expect::comma_or_end;
+  }
+
+  // string whose opening quote is at @p
+  const char* string( const char *p , const char *end )
+  {
+    const char *q = p + 1;
+    bool escapes = false;
+    bool pending = false;
+    while( true )
+    {
+      if( pending )
+      {
+        if( q == end ){ break; }
+        ++q;
+        pending = false;
+      }
+      q = parser::find_quote_or_escape( q , end );
+      if( q == end ){ break; }
+      if( *q == '\\' )
+      {
+        escapes = true;
+        pending = true;
+        ++q;
+        continue;
+      }
+      // closing quote inside this chunk
+      if( escapes == false )
+      {
+        return emit_string( std::string_view( p + 1 , q - p - 1 ) ) ? q + 1 : nullptr;
+      }
+      if( parser::parse_string( p , end , decoded_ ) == nullptr ){ return nullptr; }
+      return emit_string( decoded_ ) ? q + 1 : nullptr;
+    }
+    if( static_cast< std::size_t >( end - p ) > max_token_ ){ return nullptr; }
+    token_.assign( p , end );
+    escape_pending_ = pending;
+    state_ = state::in_string;
+    return end;
+  }
+  const char* continue_string( const char *p , const char *end )
+  {
+    const char *q = p;
+    while( true )
+    {
+      if( escape_pending_ )
+      {
+        if( q == end ){ break; }
+        ++q;
+        escape_pending_ = false;
+      }
+      q = parser::find_quote_or_escape( q , end );
+      if( q == end ){ break; }
+      if( *q == '\\' )
+      {
+        escape_pending_ = true;
+        ++q;
+        continue;
+      }
+      if( grow_token( p , q + 1 ) == false ){ return nullptr; }
+      state_ = state::between;
+      if( parser::parse_string( token_.data() , token_.data() + token_.size() , decoded_ ) == nullptr )
+      {
+        return nullptr;
+      }
+      return emit_string( decoded_ ) ? q + 1 : nullptr;
+    }
+    return grow_token( p , end ) ? end : nullptr;
+  }
+  bool emit_string( std::string_view str )
+  {
+    if( key_ )
+    {
+      expect_ = expect::colon;
+      return handler_.key( str );
+    }
+    if( handler_.string( str ) == false ){ return false; }
+    value_done();
+    return true;
+  }
+
+  // appends [ p , end ) to the split token , false past max_token_
+  bool grow_token( const char *p , const char *end )
+  {
+    if( static_cast< std::size_t >( end - p ) > max_token_ - token_.size() ){ return false; }
+    token_.append( p , end );
+    return true;
+  }
+
+  const char* continue_scalar( const char *p , const char *end )
+  {
+    const char *q = p;
+    while( q != end && parser::is_delimiter( *q ) == false ){ ++q; }
+    if( grow_token( p , q ) == false ){ return nullptr; }
+    if( q == end ){ return end; }
+    state_ = state::between;
+    return scalar( token_.data() , token_.data() + token_.size() ) ? q : nullptr;
+  }
+  // number or literal in [ p , end )
+  bool scalar( const char *p , const char *end )
+  {
+    const std::size_t n = end - p;
+    bool ok;
+    if( n == 4 && std::memcmp( p , "true" , 4 ) == 0 )
+    {
+      ok = handler_.boolean( true );
+    }else if( n == 5 && std::memcmp( p , "false" , 5 ) == 0 )
+    {
+      ok = handler_.boolean( false );
+    }else if( n == 4 && std::memcmp( p , "null" , 4 ) == 0 )
+    {
+      ok = handler_.null();
+    }else
+    {
+      json_number_t v;
+      if( parser::parse_number( p , end , v ) != end ){ return false; }
+      ok = handler_.number( v );
+    }
+    if( ok ){ value_done(); }
+    return ok;
+  }
+};
+
+// runs @handler over a complete buffer
+template < typename Handler >
+bool parse_events( const char *begin , const char *end , Handler& handler )
+{
+  event_parser< Handler > parser( handler );
+  return parser.feed( begin , end - begin ) && parser.finish();
+}
+
+}}
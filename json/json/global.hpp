@@ -1,7 +1,12 @@
 #pragma once
 
-#include <unordered_map>
+#include "arena.hpp"
+#include "object.hpp"
+
+#include <string>
 #include <vector>
+#include <memory>
+#include <scoped_allocator>
 
 namespace eh { namespace json {
 
@@ -10,19 +15,25 @@ class JsonData;
 
 using type_type = int;
 
+// containers take their memory from the node's arena ( arena.hpp ),
+// the scoped adaptor hands it on to keys and elements
+template < typename T >
+using json_allocator_t = std::scoped_allocator_adaptor< arena_allocator< T > >;
+
 //
-//! { members.... }
-using json_object_t = std::unordered_map< std::string , JsonData >;
+//! "str_value"
+using json_string_t = std::basic_string< char , std::char_traits< char > , arena_allocator< char > >;
+constexpr type_type string_type = 3;
+
+//
+//! { members.... } , in insertion order , keys interned ( object.hpp )
+using json_object_t = flat_object< JsonData >;
 constexpr type_type object_type = 1;
 //
 //! [ members... ]
-using json_array_t  = std::vector< JsonData >;
+using json_array_t  = std::vector< JsonData , json_allocator_t< JsonData > >;
 constexpr type_type array_type = 2;
 //
-//! "str_value"
-using json_string_t = std::string;
-constexpr type_type string_type = 3;
-//
 //! 1231412
 using json_int_t = int;
 constexpr type_type int_type = 4;
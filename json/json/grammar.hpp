@@ -49,34 +49,22 @@ namespace grammar
   constexpr auto string_init_lambda = []( auto& context )
   {
     // string
-    x3::_val( context ) = JsonData(
-        string_type , 
-        new json_string_t( std::move( x3::_attr( context ) ) )
-    );
+    x3::_val( context ) = JsonData( x3::_attr( context ) );
   };
   constexpr auto int_init_lambda = []( auto& context )
   {
     // int
-    x3::_val( context ) = JsonData(
-        int_type , 
-        new json_int_t( x3::_attr( context ) )
-    );
+    x3::_val( context ) = JsonData( json_int_t( x3::_attr( context ) ) );
   };
   constexpr auto number_init_lambda = []( auto& context )
   {
     // number 
-    x3::_val( context ) = JsonData(
-        number_type , 
-        new json_number_t( x3::_attr( context ) )
-    );
+    x3::_val( context ) = JsonData( json_number_t( x3::_attr( context ) ) );
   };
   constexpr auto bool_init_lambda = []( auto& context )
   {
     // bool 
-    x3::_val( context ) = JsonData(
-        bool_type , 
-        new json_bool_t( x3::_attr( context ) )
-    );
+    x3::_val( context ) = JsonData( json_bool_t( x3::_attr( context ) ) );
   };
   /*
   constexpr auto null_init_lambda = []( auto& context )
@@ -120,9 +108,11 @@ namespace grammar
   BOOST_SPIRIT_DEFINE( array_rule );
 }
 
+// the original X3 grammar, superseded by parser.hpp.
+// kept as the reference the new parser is checked against
 template < typename IterType >
 static 
-JsonData parse( IterType begin , IterType end , bool *boolptr = nullptr )
+JsonData parse_x3( IterType begin , IterType end , bool *boolptr = nullptr )
 {
   using namespace boost::spirit;
   JsonData ret;
@@ -137,7 +127,7 @@ JsonData parse( IterType begin , IterType end , bool *boolptr = nullptr )
 }
 template < typename IterType >
 static 
-JsonData parse( IterType& begin , IterType end , bool *boolptr = nullptr )
+JsonData parse_x3( IterType& begin , IterType end , bool *boolptr = nullptr )
 {
   using namespace boost::spirit;
   JsonData ret;
@@ -3,6 +3,8 @@
 #include "global.hpp"
 
 #include <ostream>
+#include <string_view>
+#include <cstdint>
 
 namespace eh{ namespace json {
 
@@ -11,21 +13,43 @@ class JsonData
 {
 #define DEFINE_AS_JSON_TYPE_METHOD( typename ) \
   inline json_##typename##_t* as_##typename() const \
-  { return reinterpret_cast< json_##typename##_t* >( data_ ); }
+  { return reinterpret_cast< json_##typename##_t* >( data_.ptr ); }
 
   DEFINE_AS_JSON_TYPE_METHOD( object );
   DEFINE_AS_JSON_TYPE_METHOD( array );
-  DEFINE_AS_JSON_TYPE_METHOD( string );
-  DEFINE_AS_JSON_TYPE_METHOD( int );
-  DEFINE_AS_JSON_TYPE_METHOD( number );
-  DEFINE_AS_JSON_TYPE_METHOD( bool );
-  DEFINE_AS_JSON_TYPE_METHOD( null );
 
 #undef DEFINE_AS_JSON_TYPE_METHOD
 
+  // an in-situ string becomes an owned one the first time it is asked for.
+  // that writes the node even through const : getString() on an in-situ
+  // string is not safe to call concurrently , getStringView() is
+  inline json_string_t* as_string() const
+  {
+    if( view_ )
+    {
+      data_.ptr = make< json_string_t >( static_cast< const char* >( data_.ptr ) , size_ );
+      view_ = false;
+    }
+    return reinterpret_cast< json_string_t* >( data_.ptr );
+  }
+
+  // scalars live in the node itself
+  inline json_int_t* as_int() const
+  { return &data_.i; }
+  inline json_number_t* as_number() const
+  { return &data_.d; }
+  inline json_bool_t* as_bool() const
+  { return &data_.b; }
+
+  // only objects, arrays and strings own memory.
+  // arena nodes release nothing , the arena goes away as a whole
   void free()
   {
-    if( data_ == nullptr ){ return; }
+    if( arena_ || view_ )
+    {
+      view_ = false;
+      return;
+    }
     switch( type_ )
     {
     default:
@@ -39,51 +63,47 @@ class JsonData
     case string_type:
       delete as_string();
       break;
-    case int_type:
-      delete as_int();
-      break;
-    case number_type:
-      delete as_number();
-      break;
-    case bool_type:
-      delete as_bool();
-      break;
     }
   }
 
   // no free;
-  // only copying
+  // only copying , into this node's arena
   void copy_from( JsonData const& rhs )
   {
-    type_ = rhs.type_;
-
-    switch( type_ )
+    view_ = false;
+    switch( rhs.type_ )
     {
     default:
-      data_ = nullptr;
+      data_ = rhs.data_;
       break;
     case object_type:
-      data_ = new json_object_t( rhs.getObject() );
+      data_.ptr = make< json_object_t >( rhs.getObject() );
       break;
     case array_type:
-      data_ = new json_array_t( rhs.getArray() );
+      data_.ptr = make< json_array_t >( rhs.getArray() );
       break;
     case string_type:
-      data_ = new json_string_t( rhs.getString() );
-      break;
-    case int_type:
-      data_ = new json_int_t( rhs.getInt() );
-      break;
-    case number_type:
-      data_ = new json_number_t( rhs.getNumber() );
-      break;
-    case bool_type:
-      data_ = new json_bool_t( rhs.getBool() );
-      break;
-    case null_type:
-      data_ = nullptr;
+      {
+        const std::string_view str = rhs.getStringView();
+        data_.ptr = make< json_string_t >( str.data() , str.size() );
+      }
       break;
     }
+    type_ = rhs.type_;
+  }
+
+  // a container for this node , placed in its arena ( or on the heap )
+  // and handing the arena down to its elements
+  template < typename T , typename ... Ts >
+  T* make( Ts&& ... args ) const
+  {
+    arena *a = arena::find( arena_ );
+    const typename T::allocator_type alloc( allocator_type{ a } );
+    if( a )
+    {
+      return new ( a->allocate( sizeof( T ) , alignof( T ) ) ) T( std::forward< Ts >( args )... , alloc );
+    }
+    return new T( std::forward< Ts >( args )... , alloc );
   }
 
   friend std::ostream& operator << ( std::ostream& , JsonData const& );
@@ -91,28 +111,70 @@ class JsonData
   void array_stream_out( std::ostream& stream ) const;
 
 public:
+  // containers pass this down , see arena.hpp
+  using allocator_type = arena_allocator< JsonData >;
+
   JsonData() :
     type_( null_type ) ,
-    data_( nullptr )
+    arena_( 0 )
   {
+    data_.ptr = nullptr;
   }
-  JsonData( JsonData const& rhs )
+  // a copy always lives on the heap
+  JsonData( JsonData const& rhs ) :
+    arena_( 0 )
   {
     copy_from( rhs );
   }
-  JsonData( JsonData&& rhs ) :
+  // noexcept , so growing a json_array_t moves instead of deep copying.
+  // the moved value keeps pointing into its arena
+  JsonData( JsonData&& rhs ) noexcept :
     type_( rhs.type_ ) ,
+    view_( rhs.view_ ) ,
+    arena_( rhs.arena_ ) ,
+    size_( rhs.size_ ) ,
     data_( rhs.data_ )
   {
+    rhs.view_ = false;
     rhs.type_ = null_type;
-    rhs.data_ = nullptr;
+    rhs.data_.ptr = nullptr;
   }
+  // takes ownership of a heap allocated object , array or string
   template < typename DataPtrType >
   explicit JsonData( type_type type , DataPtrType rhs ) :
     type_( type ) ,
-    data_( rhs )
+    arena_( 0 )
   {
+    data_.ptr = rhs;
   }
+
+  // uses-allocator construction : elements of arena containers join the arena
+  JsonData( std::allocator_arg_t , const allocator_type& alloc ) :
+    type_( null_type ) ,
+    arena_( alloc.arena_id() )
+  {
+    data_.ptr = nullptr;
+  }
+  JsonData( std::allocator_arg_t , const allocator_type& alloc , JsonData const& rhs ) :
+    arena_( alloc.arena_id() )
+  {
+    copy_from( rhs );
+  }
+  JsonData( std::allocator_arg_t , const allocator_type& alloc , JsonData&& rhs ) :
+    type_( null_type ) ,
+    arena_( alloc.arena_id() )
+  {
+    data_.ptr = nullptr;
+    *this = std::move( rhs );
+  }
+  template < typename ... Ts >
+  JsonData( std::allocator_arg_t , const allocator_type& alloc , Ts&& ... args ) :
+    JsonData( std::allocator_arg , alloc , JsonData( std::forward< Ts >( args )... ) )
+  {
+  }
+
+  // assignment keeps the arena of the target ,
+  // a value from elsewhere is copied into it
   JsonData& operator = ( JsonData const& rhs )
   {
     free();
@@ -122,11 +184,20 @@ public:
   }
   JsonData& operator = ( JsonData&& rhs )
   {
+    if( arena_ != rhs.arena_ )
+    {
+      free();
+      copy_from( rhs );
+      return *this;
+    }
     free();
     type_ = rhs.type_;
+    view_ = rhs.view_;
+    size_ = rhs.size_;
     data_ = rhs.data_;
+    rhs.view_ = false;
     rhs.type_ = null_type;
-    rhs.data_ = nullptr;
+    rhs.data_.ptr = nullptr;
 
     return *this;
   }
@@ -136,36 +207,56 @@ public:
   }
 
   JsonData( json_int_t i ) :
-    JsonData( int_type , new json_int_t( i ) )
+    type_( int_type ) ,
+    arena_( 0 )
   {
+    data_.i = i;
   }
   JsonData( json_number_t d ) :
-    JsonData( number_type , new json_number_t( d ) )
+    type_( number_type ) ,
+    arena_( 0 )
   {
+    data_.d = d;
   }
   JsonData( json_bool_t b ) :
-    JsonData( bool_type , new json_bool_t( b ) )
+    type_( bool_type ) ,
+    arena_( 0 )
   {
+    data_.b = b;
   }
   JsonData( json_null_t ) :
     JsonData( null_type , nullptr )
   {
   }
   JsonData( const char* str ) :
-    JsonData( string_type , new json_string_t( str ) )
+    type_( string_type ) ,
+    arena_( 0 )
   {
+    data_.ptr = make< json_string_t >( str );
   }
   JsonData( std::string const& str ) :
-    JsonData( string_type , new json_string_t( str ) )
+    type_( string_type ) ,
+    arena_( 0 )
   {
+    data_.ptr = make< json_string_t >( str.data() , str.size() );
   }
   JsonData( std::string&& str ) :
-    JsonData( string_type , new json_string_t( str ) )
+    type_( string_type ) ,
+    arena_( 0 )
+  {
+    data_.ptr = make< json_string_t >( str.data() , str.size() );
+  }
+  JsonData( json_string_t const& str ) :
+    type_( string_type ) ,
+    arena_( 0 )
   {
+    data_.ptr = make< json_string_t >( str );
   }
   JsonData( std::initializer_list< JsonData > list ) :
-    JsonData( array_type , new json_array_t( list ) )
+    type_( array_type ) ,
+    arena_( 0 )
   {
+    data_.ptr = make< json_array_t >( list );
   }
 
   // some convension operators...
@@ -196,10 +287,15 @@ public:
   }
   JsonData& operator = ( std::string const& str )
   {
-    resetString( str );
+    resetString( str.data() , str.size() );
     return *this;
   }
   JsonData& operator = ( std::string&& str )
+  {
+    resetString( str.data() , str.size() );
+    return *this;
+  }
+  JsonData& operator = ( json_string_t const& str )
   {
     resetString( str );
     return *this;
@@ -212,30 +308,60 @@ public:
   }
 
 
+  // @rhs_ptr is owned by the node afterwards; it has to come from the
+  // node's arena , or from new on a heap node
   void reset( type_type type = null_type , void* rhs_ptr = nullptr )
   {
     free();
     type_ = type;
-    data_ = rhs_ptr;
+    data_.ptr = rhs_ptr;
+  }
+
+  // an in-situ string : @str is referenced , not copied , and has to
+  // outlive the node ( see parse_in_situ )
+  JsonData& resetStringView( std::string_view str )
+  {
+    if( str.size() > UINT32_MAX )
+    {
+      return resetString( str.data() , str.size() );
+    }
+    free();
+    type_ = string_type;
+    view_ = true;
+    size_ = static_cast< std::uint32_t >( str.size() );
+    data_.ptr = const_cast< char* >( str.data() );
+    return *this;
   }
 
 #define DEFINE_JSON_RESET_FUNC( funcname , tpname ) \
   template < typename ... Ts > \
   inline JsonData& reset##funcname( Ts&& ... args ) \
   { \
-    reset( tpname##_type , new json_##tpname##_t( args... ) ); \
+    reset( tpname##_type , make< json_##tpname##_t >( args... ) ); \
     return *this;\
   }
 
   DEFINE_JSON_RESET_FUNC( Object , object );
   DEFINE_JSON_RESET_FUNC( Array , array );
   DEFINE_JSON_RESET_FUNC( String , string );
-  DEFINE_JSON_RESET_FUNC( Int , int );
-  DEFINE_JSON_RESET_FUNC( Number , number );
-  DEFINE_JSON_RESET_FUNC( Bool , bool );
 
 #undef DEFINE_JSON_RESET_FUNC
 
+#define DEFINE_JSON_RESET_SCALAR_FUNC( funcname , tpname , member ) \
+  inline JsonData& reset##funcname( json_##tpname##_t v = json_##tpname##_t() ) \
+  { \
+    free(); \
+    type_ = tpname##_type; \
+    data_.member = v; \
+    return *this; \
+  }
+
+  DEFINE_JSON_RESET_SCALAR_FUNC( Int , int , i );
+  DEFINE_JSON_RESET_SCALAR_FUNC( Number , number , d );
+  DEFINE_JSON_RESET_SCALAR_FUNC( Bool , bool , b );
+
+#undef DEFINE_JSON_RESET_SCALAR_FUNC
+
   inline type_type getType() const
   {
     return type_;
@@ -258,6 +384,23 @@ public:
 
 #undef DEFINE_JSON_GET_FUNC
 
+  // string_type only; does not copy an in-situ string and never writes the
+  // node , so threads sharing a const tree read strings through this
+  std::string_view getStringView() const
+  {
+    if( view_ )
+    {
+      return std::string_view( static_cast< const char* >( data_.ptr ) , size_ );
+    }
+    const json_string_t& str = *reinterpret_cast< const json_string_t* >( data_.ptr );
+    return std::string_view( str.data() , str.size() );
+  }
+  // true for a string still pointing into the parsed buffer
+  bool isStringView() const
+  {
+    return view_;
+  }
+
   bool exists( const char* name ) const
   {
     if( type_ != object_type )
@@ -321,9 +464,28 @@ public:
   }
 
 protected:
-  type_type type_;
-  void *data_;
+  // int , double and bool inline , the rest behind ptr
+  union storage_type
+  {
+    json_int_t i;
+    json_number_t d;
+    json_bool_t b;
+    void *ptr;
+  };
+
+  // a type_type , narrowed so an in-situ string's length fits in the node
+  std::uint8_t type_;
+  // string_type : data_.ptr points at size_ chars the node does not own
+  mutable bool view_ = false;
+  // arena::id() of the arena the node's containers come from , 0 : heap
+  std::uint16_t arena_;
+  mutable std::uint32_t size_ = 0;
+  // mutable : the getters hand out references from const nodes, as they did
+  // when every scalar was heap allocated
+  mutable storage_type data_;
 };
+static_assert( sizeof( JsonData ) == 16 , "JsonData is a 16 byte node" );
+static_assert( arena::max_arenas <= 1 << 16 , "arena ids are stored in 16 bits" );
 
 
 
@@ -0,0 +1,258 @@
+#pragma once
+
+#include "arena.hpp"
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <ostream>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace eh { namespace json {
+
+// FNV-1a , 32 bits; constexpr so paths can be hashed at compile time
+constexpr std::uint32_t key_hash( const char *s , std::size_t n )
+{
+  std::uint32_t h = 2166136261u;
+  for( std::size_t i = 0; i < n; ++i )
+  {
+    h = ( h ^ static_cast< unsigned char >( s[ i ] ) ) * 16777619u;
+  }
+  return h;
+}
+
+// one interned object key , never freed
+struct key_entry
+{
+  std::uint32_t id;
+  std::uint32_t hash;
+  std::uint32_t size;
+  char data[ 1 ];
+};
+
+// handle to an interned key : equal keys are the same entry ,
+// so comparing two keys is comparing two pointers
+class key
+{
+public:
+  key() :
+    entry_( nullptr )
+  {
+  }
+  explicit key( const key_entry *entry ) :
+    entry_( entry )
+  {
+  }
+  // interns @str
+  explicit key( std::string_view str );
+
+  const char* data() const
+  {
+    return entry_ ? entry_->data : "";
+  }
+  const char* c_str() const
+  {
+    return data();
+  }
+  std::size_t size() const
+  {
+    return entry_ ? entry_->size : 0;
+  }
+  // unique per key , 0 for the null key
+  std::uint32_t id() const
+  {
+    return entry_ ? entry_->id : 0;
+  }
+  std::uint32_t hash() const
+  {
+    return entry_ ? entry_->hash : 0;
+  }
+  operator std::string_view () const
+  {
+    return std::string_view( data() , size() );
+  }
+  // false for the null key , returned when a lookup finds nothing
+  explicit operator bool () const
+  {
+    return entry_ != nullptr;
+  }
+
+  bool operator == ( key rhs ) const
+  {
+    return entry_ == rhs.entry_;
+  }
+  bool operator != ( key rhs ) const
+  {
+    return entry_ != rhs.entry_;
+  }
+
+protected:
+  const key_entry *entry_;
+};
+
+inline std::ostream& operator << ( std::ostream& stream , key k )
+{
+  return stream.write( k.data() , k.size() );
+}
+
+// process wide table of object keys , safe to use from concurrent parsers.
+//
+// the table is split into shards by hash , each with its own lock and arena.
+// lookups take no lock : a shard publishes its slot array through an atomic
+// pointer , inserts fill empty slots with release stores under the shard lock ,
+// and growing publishes a new array. replaced arrays are kept until the table
+// goes away , so a reader still probing one is never left dangling; at most
+// they add up to the size of the current one.
+// keys are never removed : documents with unbounded key sets ( ids used as
+// keys ... ) grow it for the life of the process.
+class key_table
+{
+public:
+  static constexpr std::size_t shard_count = 16;
+
+  static key_table& global()
+  {
+    static key_table table;
+    return table;
+  }
+
+  // the key for @str , added if new
+  key intern( std::string_view str )
+  {
+    const std::uint32_t h = key_hash( str.data() , str.size() );
+    shard_type& shard = shards_[ h % shard_count ];
+    if( const key_entry *e = shard.find( str , h ) )
+    {
+      return key( e );
+    }
+
+    std::lock_guard< std::mutex > lock( shard.mutex );
+    slots_type *slots = shard.current.load( std::memory_order_relaxed );
+    std::size_t i = ( h / shard_count ) & slots->mask;
+    while( const key_entry *e = slots->slots[ i ].load( std::memory_order_relaxed ) )
+    {
+      if( e->hash == h && e->size == str.size() && std::memcmp( e->data , str.data() , str.size() ) == 0 )
+      {
+        return key( e );
+      }
+      i = ( i + 1 ) & slots->mask;
+    }
+
+    key_entry *e = static_cast< key_entry* >( shard.memory.allocate( offsetof( key_entry , data ) + str.size() + 1 ,
+                                                                      alignof( key_entry ) ) );
+    e->id = next_id_.fetch_add( 1 , std::memory_order_relaxed );
+    e->hash = h;
+    e->size = static_cast< std::uint32_t >( str.size() );
+    std::memcpy( e->data , str.data() , str.size() );
+    e->data[ str.size() ] = 0;
+    // publishes the filled entry to lock free readers
+    slots->slots[ i ].store( e , std::memory_order_release );
+    if( ++shard.count * 2 > slots->mask + 1 )
+    {
+      shard.grow();
+    }
+    return key( e );
+  }
+
+  // the key for @str , or the null key if it was never interned. takes no lock
+  key find( std::string_view str )
+  {
+    return find( str , key_hash( str.data() , str.size() ) );
+  }
+  // @h : key_hash( @str ) , computed beforehand
+  key find( std::string_view str , std::uint32_t h )
+  {
+    return key( shards_[ h % shard_count ].find( str , h ) );
+  }
+
+  // number of keys
+  std::size_t size()
+  {
+    std::size_t n = 0;
+    for( auto& shard : shards_ )
+    {
+      std::lock_guard< std::mutex > lock( shard.mutex );
+      n += shard.count;
+    }
+    return n;
+  }
+
+protected:
+  // open addressing , at most half full
+  struct slots_type
+  {
+    std::size_t mask;
+    std::unique_ptr< std::atomic< const key_entry* >[] > slots;
+
+    explicit slots_type( std::size_t n ) :
+      mask( n - 1 ) ,
+      slots( new std::atomic< const key_entry* >[ n ] )
+    {
+      for( std::size_t i = 0; i < n; ++i ){ slots[ i ].store( nullptr , std::memory_order_relaxed ); }
+    }
+  };
+
+  struct shard_type
+  {
+    std::mutex mutex;
+    arena memory;
+    std::atomic< slots_type* > current;
+    // every array this shard published , the current one last
+    std::vector< std::unique_ptr< slots_type > > arrays;
+    std::size_t count = 0;
+
+    shard_type() :
+      memory( 16 << 10 )
+    {
+      arrays.emplace_back( new slots_type( 64 ) );
+      current.store( arrays.back().get() , std::memory_order_release );
+    }
+
+    // lock free
+    const key_entry* find( std::string_view str , std::uint32_t h ) const
+    {
+      const slots_type *slots = current.load( std::memory_order_acquire );
+      // shards are picked by the low bits , probe with the rest
+      std::size_t i = ( h / shard_count ) & slots->mask;
+      while( const key_entry *e = slots->slots[ i ].load( std::memory_order_acquire ) )
+      {
+        if( e->hash == h && e->size == str.size() && std::memcmp( e->data , str.data() , str.size() ) == 0 )
+        {
+          return e;
+        }
+        i = ( i + 1 ) & slots->mask;
+      }
+      return nullptr;
+    }
+    // under the lock
+    void grow()
+    {
+      const slots_type *old = current.load( std::memory_order_relaxed );
+      std::unique_ptr< slots_type > grown( new slots_type( ( old->mask + 1 ) * 2 ) );
+      for( std::size_t k = 0; k <= old->mask; ++k )
+      {
+        const key_entry *e = old->slots[ k ].load( std::memory_order_relaxed );
+        if( e == nullptr ){ continue; }
+        std::size_t i = ( e->hash / shard_count ) & grown->mask;
+        while( grown->slots[ i ].load( std::memory_order_relaxed ) ){ i = ( i + 1 ) & grown->mask; }
+        grown->slots[ i ].store( e , std::memory_order_relaxed );
+      }
+      arrays.push_back( std::move( grown ) );
+      current.store( arrays.back().get() , std::memory_order_release );
+    }
+  };
+
+  shard_type shards_[ shard_count ];
+  std::atomic< std::uint32_t > next_id_{ 1 };
+};
+
+inline key::key( std::string_view str ) :
+  entry_( key_table::global().intern( str ).entry_ )
+{
+}
+
+}}
@@ -0,0 +1,379 @@
+#pragma once
+
+#include "parser.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+namespace eh { namespace json {
+
+class lazy_value;
+
+// on demand document : parse() only runs stage 1 and a structural check ,
+// recording for every '{' and '[' where its value ends. nothing is decoded
+// until it is read through a lazy_value , and unread subtrees are stepped
+// over in one jump.
+//
+// the input is read again on every access : the buffer has to stay alive and
+// unchanged while the document is used. numbers , literals and string
+// contents are only checked when read; a malformed one reads as the fallback.
+//
+//  lazy_document doc;
+//  if( doc.parse( text.data() , text.data() + text.size() ) )
+//  {
+//    const double price = doc.root()[ "order" ][ "price" ].getNumber();
+//  }
+class lazy_document
+{
+public:
+  lazy_document() :
+    buf_( "" ) ,
+    len_( 0 ) ,
+    tape_( 1 , 0 )
+  {
+  }
+
+  // false if [ begin , end ) is not a single well formed value
+  bool parse( const char *begin , const char *end )
+  {
+    buf_ = begin;
+    len_ = end - begin;
+    // tape positions are 32 bit , as in stage 1
+    const bool fits = len_ <= parser::max_length;
+    if( fits )
+    {
+      parser::index_structurals( buf_ , len_ , index_ );
+    }
+    if( fits == false || validate() == false )
+    {
+      index_.clear();
+      tape_.assign( 1 , 0 );
+      return false;
+    }
+    return true;
+  }
+
+  // null if parse() failed
+  lazy_value root() const;
+
+protected:
+  friend class lazy_value;
+
+  const char *buf_;
+  std::size_t len_;
+  // stage 1 structural positions
+  std::vector< std::uint32_t > index_;
+  // the character at each position , 0 terminated
+  std::vector< char > tape_;
+  // for '{' and '[' entries : the entry after the matching close
+  std::vector< std::uint32_t > jump_;
+  std::vector< std::uint32_t > stack_;
+
+  // 0 past the end
+  char at( std::uint32_t k ) const
+  {
+    return tape_[ k ];
+  }
+  // the entry after the value starting at @k
+  std::uint32_t skip( std::uint32_t k ) const
+  {
+    const char c = at( k );
+    return c == '{' || c == '[' ? jump_[ k ] : k + 1;
+  }
+
+  // position after the closing quote of the string at @p , null if there is none
+  const char* string_end( const char *p ) const
+  {
+    const char *end = buf_ + len_;
+    ++p;
+    while( true )
+    {
+      p = parser::find_quote_or_escape( p , end );
+      if( p == end ){ return nullptr; }
+      if( *p == '"' ){ return p + 1; }
+      p += 2;
+      if( p >= end ){ return nullptr; }
+    }
+  }
+
+  // the key string at @k equals @name
+  bool key_equals( std::uint32_t k , std::string_view name ) const
+  {
+    const char *p = buf_ + index_[ k ] + 1;
+    const char *end = buf_ + len_;
+    const char *q = parser::find_quote_or_escape( p , end );
+    if( q != end && *q == '"' )
+    {
+      return static_cast< std::size_t >( q - p ) == name.size() && std::memcmp( p , name.data() , name.size() ) == 0;
+    }
+    std::string decoded;
+    return parser::parse_string( p - 1 , end , decoded ) != nullptr && decoded == name;
+  }
+
+  // fills tape_ and jump_ , checking the structure
+  bool validate()
+  {
+    const std::uint32_t n = static_cast< std::uint32_t >( index_.size() );
+    tape_.resize( n + 1 );
+    for( std::uint32_t i = 0; i < n; ++i )
+    {
+      tape_[ i ] = buf_[ index_[ i ] ];
+    }
+    tape_[ n ] = 0;
+    jump_.resize( n );
+    stack_.clear();
+    std::uint32_t k = 0;
+
+  value:
+    switch( at( k ) )
+    {
+    case '{':
+      stack_.push_back( k++ );
+      if( at( k ) == '}' ){ goto close; }
+      goto member;
+    case '[':
+      stack_.push_back( k++ );
+      if( at( k ) == ']' ){ goto close; }
+      goto value;
+    case '"':
+      ++k;
+      goto end_value;
+    case '-': case '0': case '1': case '2': case '3': case '4':
+    case '5': case '6': case '7': case '8': case '9':
+    case 't': case 'f': case 'n':
+      ++k;
+      goto end_value;
+    default:
+      return false;
+    }
+
+  member:
+    if( at( k ) != '"' || at( k + 1 ) != ':' ){ return false; }
+    k += 2;
+    goto value;
+
+  close:
+    jump_[ stack_.back() ] = k + 1;
+    stack_.pop_back();
+    ++k;
+    goto end_value;
+
+  end_value:
+    if( stack_.empty() )
+    {
+      if( k != n ){ return false; }
+      // an unterminated string swallows the rest of the input , so only the last one can be
+      return at( n - 1 ) != '"' || string_end( buf_ + index_[ n - 1 ] ) != nullptr;
+    }
+    {
+      const bool object = at( stack_.back() ) == '{';
+      const char c = at( k );
+      if( c == ',' )
+      {
+        ++k;
+        if( object ){ goto member; }
+        goto value;
+      }
+      if( c == ( object ? '}' : ']' ) ){ goto close; }
+      return false;
+    }
+  }
+};
+
+// a value inside a lazy_document , decoded when read.
+// a missing member or element is invalid : valid() is false and it reads as null
+class lazy_value
+{
+public:
+  lazy_value() :
+    doc_( nullptr ) ,
+    k_( npos )
+  {
+  }
+  lazy_value( const lazy_document *doc , std::uint32_t k ) :
+    doc_( doc ) ,
+    k_( k )
+  {
+  }
+
+  bool valid() const
+  {
+    return k_ != npos;
+  }
+  type_type getType() const
+  {
+    switch( first() )
+    {
+    case '{': return object_type;
+    case '[': return array_type;
+    case '"': return string_type;
+    case 't': case 'f': return bool_type;
+    case 'n': case 0: return null_type;
+    default: return number_type;
+    }
+  }
+  bool isNull() const
+  {
+    return getType() == null_type;
+  }
+
+  // first member named @name
+  lazy_value operator [] ( std::string_view name ) const
+  {
+    if( first() != '{' ){ return lazy_value(); }
+    std::uint32_t j = k_ + 1;
+    while( doc_->at( j ) == '"' )
+    {
+      if( doc_->key_equals( j , name ) ){ return lazy_value( doc_ , j + 2 ); }
+      j = doc_->skip( j + 2 );
+      if( doc_->at( j ) != ',' ){ break; }
+      ++j;
+    }
+    return lazy_value();
+  }
+  lazy_value operator [] ( const char *name ) const
+  {
+    return ( *this )[ std::string_view( name ) ];
+  }
+  lazy_value operator [] ( std::size_t i ) const
+  {
+    if( first() != '[' || doc_->at( k_ + 1 ) == ']' ){ return lazy_value(); }
+    std::uint32_t j = k_ + 1;
+    for( ; i; --i )
+    {
+      j = doc_->skip( j );
+      if( doc_->at( j ) != ',' ){ return lazy_value(); }
+      ++j;
+    }
+    return lazy_value( doc_ , j );
+  }
+  bool exists( std::string_view name ) const
+  {
+    return ( *this )[ name ].valid();
+  }
+
+  // elements of an array or members of an object , counted by walking them
+  std::size_t size() const
+  {
+    std::size_t n = 0;
+    if( first() == '[' )
+    {
+      for_each_element( [ &n ]( lazy_value ){ ++n; } );
+    }else if( first() == '{' )
+    {
+      for_each_member( [ &n ]( std::string_view , lazy_value ){ ++n; } );
+    }
+    return n;
+  }
+
+  // @f( lazy_value ) for each element
+  template < typename F >
+  void for_each_element( F f ) const
+  {
+    if( first() != '[' || doc_->at( k_ + 1 ) == ']' ){ return; }
+    std::uint32_t j = k_ + 1;
+    while( true )
+    {
+      f( lazy_value( doc_ , j ) );
+      j = doc_->skip( j );
+      if( doc_->at( j ) != ',' ){ return; }
+      ++j;
+    }
+  }
+  // @f( std::string_view key , lazy_value ) for each member
+  template < typename F >
+  void for_each_member( F f ) const
+  {
+    if( first() != '{' ){ return; }
+    std::string scratch;
+    std::uint32_t j = k_ + 1;
+    while( doc_->at( j ) == '"' )
+    {
+      f( lazy_value( doc_ , j ).getStringView( scratch ) , lazy_value( doc_ , j + 2 ) );
+      j = doc_->skip( j + 2 );
+      if( doc_->at( j ) != ',' ){ return; }
+      ++j;
+    }
+  }
+
+  json_number_t getNumber( json_number_t fallback = 0 ) const
+  {
+    json_number_t v;
+    if( getType() != number_type || parser::parse_number( position() , end() , v ) == nullptr )
+    {
+      return fallback;
+    }
+    return v;
+  }
+  json_int_t getInt( json_int_t fallback = 0 ) const
+  {
+    return getType() == number_type ? static_cast< json_int_t >( getNumber( fallback ) ) : fallback;
+  }
+  json_bool_t getBool( json_bool_t fallback = false ) const
+  {
+    if( parser::match_literal( position() , end() , "true" , 4 ) ){ return true; }
+    if( parser::match_literal( position() , end() , "false" , 5 ) ){ return false; }
+    return fallback;
+  }
+  // points into the buffer , or into @scratch when the string has escapes
+  std::string_view getStringView( std::string& scratch ) const
+  {
+    if( first() != '"' ){ return std::string_view(); }
+    const char *p = position() + 1;
+    const char *q = parser::find_quote_or_escape( p , end() );
+    if( q != end() && *q == '"' )
+    {
+      return std::string_view( p , q - p );
+    }
+    if( parser::parse_string( p - 1 , end() , scratch ) == nullptr ){ return std::string_view(); }
+    return scratch;
+  }
+  std::string getString() const
+  {
+    std::string scratch;
+    const std::string_view str = getStringView( scratch );
+    return str.data() == scratch.data() ? scratch : std::string( str );
+  }
+
+  // the whole subtree as a JsonData
+  JsonData materialize() const
+  {
+    JsonData out;
+    if( valid() )
+    {
+      parser::dom_builder builder( doc_->buf_ , doc_->len_ , doc_->index_ , false , k_ );
+      std::size_t consumed;
+      if( builder.build( out , consumed ) == false ){ out.reset(); }
+    }
+    return out;
+  }
+
+protected:
+  static constexpr std::uint32_t npos = ~std::uint32_t( 0 );
+
+  const lazy_document *doc_;
+  std::uint32_t k_;
+
+  char first() const
+  {
+    return valid() ? doc_->at( k_ ) : 0;
+  }
+  const char* position() const
+  {
+    return valid() ? doc_->buf_ + doc_->index_[ k_ ] : end();
+  }
+  const char* end() const
+  {
+    return doc_ ? doc_->buf_ + doc_->len_ : nullptr;
+  }
+};
+
+inline lazy_value lazy_document::root() const
+{
+  return index_.empty() ? lazy_value() : lazy_value( this , 0 );
+}
+
+}}
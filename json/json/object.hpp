@@ -0,0 +1,538 @@
+#pragma once
+
+#include "arena.hpp"
+#include "keys.hpp"
+
+#include <vector>
+#include <memory>
+#include <iterator>
+#include <type_traits>
+#include <tuple>
+#include <utility>
+#include <string_view>
+#include <scoped_allocator>
+#include <cstdint>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace eh { namespace json {
+
+// vector whose elements never move while it grows : chunk k holds
+// first_chunk << k elements , so appending allocates a new chunk instead of
+// reallocating , and the chunks together are no larger than a vector's buffer.
+// references stay valid until their element is erased ( erase() shifts the
+// elements after it down ) or the container is cleared or destroyed.
+template < typename T , typename Alloc >
+class segmented_vector
+{
+  using traits = std::allocator_traits< Alloc >;
+  using chunks_type = std::vector< T* , typename traits::template rebind_alloc< T* > >;
+
+public:
+  using value_type = T;
+  using allocator_type = Alloc;
+  using size_type = std::size_t;
+
+  static constexpr std::size_t first_chunk = 4;
+
+  template < bool Const >
+  class basic_iterator
+  {
+    using owner_type = typename std::conditional< Const , const segmented_vector , segmented_vector >::type;
+
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = typename std::conditional< Const , const T* , T* >::type;
+    using reference = typename std::conditional< Const , const T& , T& >::type;
+
+    basic_iterator() :
+      owner_( nullptr ) ,
+      i_( 0 )
+    {
+    }
+    basic_iterator( owner_type *owner , std::size_t i ) :
+      owner_( owner ) ,
+      i_( i )
+    {
+    }
+    // iterator to const_iterator
+    template < bool C , typename = typename std::enable_if< Const && C == false >::type >
+    basic_iterator( const basic_iterator< C >& rhs ) :
+      owner_( rhs.owner_ ) ,
+      i_( rhs.i_ )
+    {
+    }
+
+    reference operator * () const { return owner_->at( i_ ); }
+    pointer operator -> () const { return &owner_->at( i_ ); }
+    reference operator [] ( difference_type n ) const { return owner_->at( i_ + n ); }
+
+    basic_iterator& operator ++ () { ++i_; return *this; }
+    basic_iterator& operator -- () { --i_; return *this; }
+    basic_iterator operator ++ ( int ) { basic_iterator r = *this; ++i_; return r; }
+    basic_iterator operator -- ( int ) { basic_iterator r = *this; --i_; return r; }
+    basic_iterator& operator += ( difference_type n ) { i_ += n; return *this; }
+    basic_iterator& operator -= ( difference_type n ) { i_ -= n; return *this; }
+    basic_iterator operator + ( difference_type n ) const { return basic_iterator( owner_ , i_ + n ); }
+    basic_iterator operator - ( difference_type n ) const { return basic_iterator( owner_ , i_ - n ); }
+    difference_type operator - ( const basic_iterator& rhs ) const
+    {
+      return static_cast< difference_type >( i_ ) - static_cast< difference_type >( rhs.i_ );
+    }
+
+    bool operator == ( const basic_iterator& rhs ) const { return i_ == rhs.i_; }
+    bool operator != ( const basic_iterator& rhs ) const { return i_ != rhs.i_; }
+    bool operator < ( const basic_iterator& rhs ) const { return i_ < rhs.i_; }
+    bool operator > ( const basic_iterator& rhs ) const { return i_ > rhs.i_; }
+    bool operator <= ( const basic_iterator& rhs ) const { return i_ <= rhs.i_; }
+    bool operator >= ( const basic_iterator& rhs ) const { return i_ >= rhs.i_; }
+
+  protected:
+    friend class basic_iterator< Const == false >;
+
+    owner_type *owner_;
+    std::size_t i_;
+  };
+  using iterator = basic_iterator< false >;
+  using const_iterator = basic_iterator< true >;
+
+  segmented_vector() :
+    segmented_vector( Alloc() )
+  {
+  }
+  explicit segmented_vector( const Alloc& alloc ) :
+    alloc_( alloc ) ,
+    chunks_( typename chunks_type::allocator_type( alloc ) ) ,
+    size_( 0 )
+  {
+  }
+  segmented_vector( const segmented_vector& rhs ) :
+    segmented_vector( rhs , traits::select_on_container_copy_construction( rhs.alloc_ ) )
+  {
+  }
+  segmented_vector( const segmented_vector& rhs , const Alloc& alloc ) :
+    segmented_vector( alloc )
+  {
+    append( rhs );
+  }
+  segmented_vector( segmented_vector&& rhs ) noexcept :
+    alloc_( rhs.alloc_ ) ,
+    chunks_( std::move( rhs.chunks_ ) ) ,
+    size_( rhs.size_ )
+  {
+    rhs.chunks_.clear();
+    rhs.size_ = 0;
+  }
+  segmented_vector( segmented_vector&& rhs , const Alloc& alloc ) :
+    segmented_vector( alloc )
+  {
+    if( alloc_ == rhs.alloc_ )
+    {
+      steal( rhs );
+    }else
+    {
+      append( std::move( rhs ) );
+    }
+  }
+  segmented_vector& operator = ( const segmented_vector& rhs )
+  {
+    if( this != &rhs )
+    {
+      clear();
+      append( rhs );
+    }
+    return *this;
+  }
+  segmented_vector& operator = ( segmented_vector&& rhs )
+  {
+    if( this == &rhs )
+    {
+      return *this;
+    }
+    if( traits::propagate_on_container_move_assignment::value || alloc_ == rhs.alloc_ )
+    {
+      release();
+      alloc_ = rhs.alloc_;
+      steal( rhs );
+    }else
+    {
+      clear();
+      append( std::move( rhs ) );
+    }
+    return *this;
+  }
+  ~segmented_vector()
+  {
+    release();
+  }
+
+  allocator_type get_allocator() const
+  {
+    return alloc_;
+  }
+
+  iterator begin() { return iterator( this , 0 ); }
+  iterator end() { return iterator( this , size_ ); }
+  const_iterator begin() const { return const_iterator( this , 0 ); }
+  const_iterator end() const { return const_iterator( this , size_ ); }
+
+  size_type size() const
+  {
+    return size_;
+  }
+  bool empty() const
+  {
+    return size_ == 0;
+  }
+  size_type capacity() const
+  {
+    return first_chunk * ( ( std::size_t( 1 ) << chunks_.size() ) - 1 );
+  }
+
+  T& at( std::size_t i )
+  {
+    const std::size_t j = i + first_chunk;
+    const int k = 63 - __builtin_clzll( j ) - chunk_shift;
+    return chunks_[ k ][ j - ( first_chunk << k ) ];
+  }
+  const T& at( std::size_t i ) const
+  {
+    return const_cast< segmented_vector* >( this )->at( i );
+  }
+  T& operator [] ( std::size_t i ) { return at( i ); }
+  const T& operator [] ( std::size_t i ) const { return at( i ); }
+
+  void reserve( size_type n )
+  {
+    while( capacity() < n )
+    {
+      chunks_.push_back( traits::allocate( alloc_ , first_chunk << chunks_.size() ) );
+    }
+  }
+
+  template < typename ... Ts >
+  T& emplace_back( Ts&& ... args )
+  {
+    reserve( size_ + 1 );
+    T *p = &at( size_ );
+    traits::construct( alloc_ , p , std::forward< Ts >( args )... );
+    ++size_;
+    return *p;
+  }
+
+  iterator erase( const_iterator pos )
+  {
+    const std::size_t i = pos - begin();
+    for( std::size_t j = i; j + 1 < size_; ++j )
+    {
+      at( j ) = std::move( at( j + 1 ) );
+    }
+    traits::destroy( alloc_ , &at( size_ - 1 ) );
+    --size_;
+    return begin() + i;
+  }
+
+  // destroys the elements , keeps the chunks
+  void clear()
+  {
+    for( std::size_t i = 0; i < size_; ++i )
+    {
+      traits::destroy( alloc_ , &at( i ) );
+    }
+    size_ = 0;
+  }
+
+protected:
+  static constexpr int chunk_shift = 2;
+  static_assert( first_chunk == std::size_t( 1 ) << chunk_shift , "first_chunk is 1 << chunk_shift" );
+
+  Alloc alloc_;
+  chunks_type chunks_;
+  std::size_t size_;
+
+  void release()
+  {
+    clear();
+    for( std::size_t k = 0; k < chunks_.size(); ++k )
+    {
+      traits::deallocate( alloc_ , chunks_[ k ] , first_chunk << k );
+    }
+    chunks_.clear();
+  }
+  void steal( segmented_vector& rhs )
+  {
+    chunks_ = std::move( rhs.chunks_ );
+    size_ = rhs.size_;
+    rhs.chunks_.clear();
+    rhs.size_ = 0;
+  }
+  void append( const segmented_vector& rhs )
+  {
+    reserve( size_ + rhs.size_ );
+    for( const T& v : rhs ){ emplace_back( v ); }
+  }
+  void append( segmented_vector&& rhs )
+  {
+    reserve( size_ + rhs.size_ );
+    for( T& v : rhs ){ emplace_back( std::move( v ) ); }
+    rhs.clear();
+  }
+};
+
+// object members , in insertion order.
+//
+// members live in a segmented_vector , so adding one never moves the others :
+// a reference to a member stays valid until that member is erased ( which
+// shifts the members after it ) or the object is cleared , and
+// d[ "a" ] = d[ "b" ] is safe.
+//
+// keys are interned ( keys.hpp ) and each member's key id is kept in a
+// contiguous parallel array. small objects are searched by comparing four ids at a
+// time; past index_threshold members an open addressing index over the ids
+// is kept as well.
+// lookups by string hash once into the key table , lookups by key do not
+// hash at all; neither allocates.
+//
+// keys must not be changed through iterators.
+template < typename Value >
+class flat_object
+{
+public:
+  using key_type = key;
+  using mapped_type = Value;
+  using value_type = std::pair< key , Value >;
+  using allocator_type = std::scoped_allocator_adaptor< arena_allocator< value_type > >;
+  using size_type = std::size_t;
+
+protected:
+  using members_type = segmented_vector< value_type , allocator_type >;
+  using ids_type = std::vector< std::uint32_t , arena_allocator< std::uint32_t > >;
+
+public:
+  using iterator = typename members_type::iterator;
+  using const_iterator = typename members_type::const_iterator;
+
+  static constexpr std::size_t index_threshold = 16;
+
+  flat_object() = default;
+  explicit flat_object( const allocator_type& alloc ) :
+    members_( alloc ) ,
+    ids_( alloc ) ,
+    index_( alloc )
+  {
+  }
+  flat_object( const flat_object& ) = default;
+  flat_object( flat_object&& ) = default;
+  flat_object( const flat_object& rhs , const allocator_type& alloc ) :
+    members_( rhs.members_ , alloc ) ,
+    ids_( rhs.ids_ , alloc ) ,
+    index_( rhs.index_ , alloc )
+  {
+  }
+  flat_object( flat_object&& rhs , const allocator_type& alloc ) :
+    members_( std::move( rhs.members_ ) , alloc ) ,
+    ids_( std::move( rhs.ids_ ) , alloc ) ,
+    index_( std::move( rhs.index_ ) , alloc )
+  {
+  }
+  flat_object& operator = ( const flat_object& ) = default;
+  flat_object& operator = ( flat_object&& ) = default;
+
+  allocator_type get_allocator() const
+  {
+    return members_.get_allocator();
+  }
+
+  iterator begin() { return members_.begin(); }
+  iterator end() { return members_.end(); }
+  const_iterator begin() const { return members_.begin(); }
+  const_iterator end() const { return members_.end(); }
+
+  size_type size() const
+  {
+    return members_.size();
+  }
+  bool empty() const
+  {
+    return members_.empty();
+  }
+  void reserve( size_type n )
+  {
+    members_.reserve( n );
+    ids_.reserve( n );
+  }
+  void clear()
+  {
+    members_.clear();
+    ids_.clear();
+    index_.clear();
+  }
+
+  iterator find( key k )
+  {
+    return members_.begin() + position( k.id() );
+  }
+  const_iterator find( key k ) const
+  {
+    return members_.begin() + position( k.id() );
+  }
+  iterator find( std::string_view str )
+  {
+    return find( key_table::global().find( str ) );
+  }
+  const_iterator find( std::string_view str ) const
+  {
+    return find( key_table::global().find( str ) );
+  }
+  template < typename K >
+  size_type count( const K& k ) const
+  {
+    return find( k ) != end() ? 1 : 0;
+  }
+
+  // appends @k with a value constructed from @args unless it exists
+  template < typename ... Ts >
+  std::pair< iterator , bool > try_emplace( key k , Ts&& ... args )
+  {
+    const std::size_t i = position( k.id() );
+    if( i != members_.size() )
+    {
+      return { members_.begin() + i , false };
+    }
+    if( members_.capacity() == 0 )
+    {
+      reserve( 4 );
+    }
+    members_.emplace_back( std::piecewise_construct ,
+                           std::forward_as_tuple( k ) ,
+                           std::forward_as_tuple( std::forward< Ts >( args )... ) );
+    ids_.push_back( k.id() );
+    if( index_.empty() == false || members_.size() > index_threshold )
+    {
+      index_insert( i );
+    }
+    return { members_.begin() + i , true };
+  }
+  template < typename ... Ts >
+  std::pair< iterator , bool > try_emplace( std::string_view str , Ts&& ... args )
+  {
+    return try_emplace( key( str ) , std::forward< Ts >( args )... );
+  }
+  Value& operator [] ( key k )
+  {
+    return try_emplace( k ).first->second;
+  }
+  Value& operator [] ( std::string_view str )
+  {
+    return try_emplace( key( str ) ).first->second;
+  }
+
+  iterator erase( const_iterator pos )
+  {
+    const std::size_t i = pos - members_.begin();
+    ids_.erase( ids_.begin() + i );
+    const iterator ret = members_.erase( pos );
+    if( index_.empty() == false )
+    {
+      rebuild_index();
+    }
+    return ret;
+  }
+  template < typename K >
+  size_type erase( const K& k )
+  {
+    const const_iterator i = find( k );
+    if( i == end() )
+    {
+      return 0;
+    }
+    erase( i );
+    return 1;
+  }
+
+protected:
+  members_type members_;
+  ids_type ids_;
+  // member position + 1 , 0 : empty slot. empty below index_threshold
+  ids_type index_;
+
+  static std::size_t slot_of( std::uint32_t id )
+  {
+    return id * 2654435761u;
+  }
+
+  // position of the key with @id , size() if absent
+  std::size_t position( std::uint32_t id ) const
+  {
+    const std::size_t n = ids_.size();
+    if( id == 0 )
+    {
+      return n;
+    }
+    if( index_.empty() == false )
+    {
+      const std::size_t mask = index_.size() - 1;
+      for( std::size_t slot = slot_of( id ) & mask; index_[ slot ]; slot = ( slot + 1 ) & mask )
+      {
+        const std::size_t i = index_[ slot ] - 1;
+        if( ids_[ i ] == id ){ return i; }
+      }
+      return n;
+    }
+
+    const std::uint32_t *p = ids_.data();
+    std::size_t i = 0;
+#ifdef __SSE2__
+    const __m128i needle = _mm_set1_epi32( static_cast< int >( id ) );
+    for( ; i + 4 <= n; i += 4 )
+    {
+      const __m128i v = _mm_loadu_si128( reinterpret_cast< const __m128i* >( p + i ) );
+      const int mask = _mm_movemask_ps( _mm_castsi128_ps( _mm_cmpeq_epi32( v , needle ) ) );
+      if( mask ){ return i + __builtin_ctz( mask ); }
+    }
+#endif
+    for( ; i < n; ++i )
+    {
+      if( p[ i ] == id ){ return i; }
+    }
+    return n;
+  }
+
+  // keeps the index at most half full
+  void index_insert( std::size_t i )
+  {
+    if( members_.size() * 2 > index_.size() )
+    {
+      rebuild_index();
+      return;
+    }
+    const std::size_t mask = index_.size() - 1;
+    std::size_t slot = slot_of( ids_[ i ] ) & mask;
+    while( index_[ slot ] ){ slot = ( slot + 1 ) & mask; }
+    index_[ slot ] = static_cast< std::uint32_t >( i + 1 );
+  }
+  void rebuild_index()
+  {
+    if( members_.size() <= index_threshold )
+    {
+      index_.clear();
+      return;
+    }
+    std::size_t slots = 64;
+    while( slots < members_.size() * 4 ){ slots *= 2; }
+    index_.assign( slots , 0 );
+    const std::size_t mask = slots - 1;
+    for( std::size_t i = 0; i < ids_.size(); ++i )
+    {
+      std::size_t slot = slot_of( ids_[ i ] ) & mask;
+      while( index_[ slot ] ){ slot = ( slot + 1 ) & mask; }
+      index_[ slot ] = static_cast< std::uint32_t >( i + 1 );
+    }
+  }
+};
+
+}}
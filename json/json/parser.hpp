@@ -0,0 +1,703 @@
+#pragma once
+
+#include "global.hpp"
+#include "json.hpp"
+
+#include <string>
+#include <vector>
+#include <iterator>
+#include <type_traits>
+#include <cstring>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace eh { namespace json {
+
+// two stage parser
+//
+// stage 1 scans the input 64 bytes at a time and records the position of every
+// structural character ( { } [ ] : , ) outside strings, every opening quote and
+// the first character of every number / literal.
+// stage 2 walks those positions with an explicit stack and builds the JsonData tree,
+// so nesting depth is not limited by the call stack.
+//
+// accepted input is the same as the former X3 grammar ( grammar.hpp ) :
+//  - a missing value is null  : { "a" : , "b" : [ 1 , , 2 ] }
+//  - every number is a number_type ( double )
+//  - parse() succeeds once one value was read, trailing input is left alone
+// and additionally {} , [] , and escape sequences in strings.
+namespace parser
+{
+  constexpr unsigned block_size = 64;
+
+#ifdef __SSE2__
+  inline std::uint64_t movemask64( __m128i a , __m128i b , __m128i c , __m128i d )
+  {
+    return
+      static_cast< std::uint64_t >( static_cast< std::uint16_t >( _mm_movemask_epi8( a ) ) ) |
+      static_cast< std::uint64_t >( static_cast< std::uint16_t >( _mm_movemask_epi8( b ) ) ) << 16 |
+      static_cast< std::uint64_t >( static_cast< std::uint16_t >( _mm_movemask_epi8( c ) ) ) << 32 |
+      static_cast< std::uint64_t >( static_cast< std::uint16_t >( _mm_movemask_epi8( d ) ) ) << 48;
+  }
+#endif
+
+  // bit masks of one 64 byte block
+  struct block_masks
+  {
+    std::uint64_t quote;
+    std::uint64_t backslash;
+    // { } [ ] : ,
+    std::uint64_t op;
+    // space \t \n \r
+    std::uint64_t space;
+  };
+
+  inline block_masks classify( const char *p )
+  {
+    block_masks m;
+#ifdef __SSE2__
+    __m128i v[ 4 ];
+    for( int i = 0; i < 4; ++i )
+    {
+      v[ i ] = _mm_loadu_si128( reinterpret_cast< const __m128i* >( p + 16 * i ) );
+    }
+    auto eq = [ & ]( char c )
+    {
+      const __m128i s = _mm_set1_epi8( c );
+      return movemask64(
+          _mm_cmpeq_epi8( v[ 0 ] , s ) , _mm_cmpeq_epi8( v[ 1 ] , s ) ,
+          _mm_cmpeq_epi8( v[ 2 ] , s ) , _mm_cmpeq_epi8( v[ 3 ] , s ) );
+    };
+    m.quote = eq( '"' );
+    m.backslash = eq( '\\' );
+    // '[' ']' and '{' '}' differ by 0x20 from each other : fold with an or
+    {
+      const __m128i fold = _mm_set1_epi8( 0x20 );
+      const __m128i open = _mm_set1_epi8( '{' );
+      const __m128i close = _mm_set1_epi8( '}' );
+      __m128i r[ 4 ];
+      for( int i = 0; i < 4; ++i )
+      {
+        const __m128i f = _mm_or_si128( v[ i ] , fold );
+        r[ i ] = _mm_or_si128( _mm_cmpeq_epi8( f , open ) , _mm_cmpeq_epi8( f , close ) );
+      }
+      m.op = movemask64( r[ 0 ] , r[ 1 ] , r[ 2 ] , r[ 3 ] ) | eq( ':' ) | eq( ',' );
+    }
+    m.space = eq( ' ' ) | eq( '\t' ) | eq( '\n' ) | eq( '\r' );
+#else
+    m.quote = m.backslash = m.op = m.space = 0;
+    for( unsigned i = 0; i < block_size; ++i )
+    {
+      const std::uint64_t bit = std::uint64_t( 1 ) << i;
+      switch( p[ i ] )
+      {
+      case '"': m.quote |= bit; break;
+      case '\\': m.backslash |= bit; break;
+      case '{': case '}': case '[': case ']': case ':': case ',': m.op |= bit; break;
+      case ' ': case '\t': case '\n': case '\r': m.space |= bit; break;
+      default: break;
+      }
+    }
+#endif
+    return m;
+  }
+
+  // bit i set if an odd number of bits at or below i are set
+  inline std::uint64_t prefix_xor( std::uint64_t x )
+  {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+  }
+
+  inline int trailing_zeros( std::uint64_t x )
+  {
+    return __builtin_ctzll( x );
+  }
+
+  // stage 1 positions are 32 bit , longer inputs are rejected
+  constexpr std::size_t max_length = 0xffffffffu;
+
+  // stage 1 : positions of structural characters in [ buf , buf + len )
+  inline void index_structurals( const char *buf , std::size_t len , std::vector< std::uint32_t >& out )
+  {
+    out.clear();
+    out.reserve( len / 6 + 8 );
+
+    // carried between blocks
+    std::uint64_t prev_escaped = 0;
+    std::uint64_t prev_in_string = 0;
+    // previous block ended in whitespace , an operator or a closing quote ( start counts as such )
+    std::uint64_t prev_separator = 1;
+
+    char tail[ block_size ];
+    for( std::size_t base = 0; base < len; base += block_size )
+    {
+      const char *p = buf + base;
+      if( len - base < block_size )
+      {
+        std::memset( tail , ' ' , block_size );
+        std::memcpy( tail , p , len - base );
+        p = tail;
+      }
+      const block_masks m = classify( p );
+
+      // escaped characters : a backslash escapes the next one, itself included
+      std::uint64_t escaped = prev_escaped;
+      prev_escaped = 0;
+      std::uint64_t bs = m.backslash & ~escaped;
+      while( bs )
+      {
+        const int i = trailing_zeros( bs );
+        if( i == 63 )
+        {
+          prev_escaped = 1;
+          bs = 0;
+        }else
+        {
+          escaped |= std::uint64_t( 1 ) << ( i + 1 );
+          bs &= ~( std::uint64_t( 3 ) << i );
+        }
+      }
+
+      const std::uint64_t quote = m.quote & ~escaped;
+      // in_string covers the opening quote and the string body, not the closing quote
+      const std::uint64_t in_string = prefix_xor( quote ) ^ prev_in_string;
+      prev_in_string = static_cast< std::uint64_t >( static_cast< std::int64_t >( in_string ) >> 63 );
+
+      const std::uint64_t op = m.op & ~in_string;
+      const std::uint64_t separator = op | ( m.space & ~in_string );
+      // a closing quote ends a token too , so a scalar glued to a string ( "a"1 )
+      // is indexed and rejected by stage 2 instead of being skipped over
+      const std::uint64_t token_end = separator | ( quote & ~in_string );
+      // first character of a scalar : not a separator, preceded by one or by a string , outside strings
+      const std::uint64_t preceded = ( token_end << 1 ) | prev_separator;
+      const std::uint64_t scalar = ~separator & ~in_string & ~quote & preceded;
+      prev_separator = token_end >> 63;
+
+      std::uint64_t structural = op | ( quote & in_string ) | scalar;
+      if( len - base < block_size )
+      {
+        structural &= ( std::uint64_t( 1 ) << ( len - base ) ) - 1;
+      }
+      while( structural )
+      {
+        out.push_back( static_cast< std::uint32_t >( base + trailing_zeros( structural ) ) );
+        structural &= structural - 1;
+      }
+    }
+  }
+
+  inline int hex_value( char c )
+  {
+    if( c >= '0' && c <= '9' ){ return c - '0'; }
+    if( c >= 'a' && c <= 'f' ){ return c - 'a' + 10; }
+    if( c >= 'A' && c <= 'F' ){ return c - 'A' + 10; }
+    return -1;
+  }
+  inline void append_utf8( std::string& out , std::uint32_t cp )
+  {
+    if( cp < 0x80 )
+    {
+      out += static_cast< char >( cp );
+    }else if( cp < 0x800 )
+    {
+      out += static_cast< char >( 0xC0 | ( cp >> 6 ) );
+      out += static_cast< char >( 0x80 | ( cp & 0x3F ) );
+    }else if( cp < 0x10000 )
+    {
+      out += static_cast< char >( 0xE0 | ( cp >> 12 ) );
+      out += static_cast< char >( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+      out += static_cast< char >( 0x80 | ( cp & 0x3F ) );
+    }else
+    {
+      out += static_cast< char >( 0xF0 | ( cp >> 18 ) );
+      out += static_cast< char >( 0x80 | ( ( cp >> 12 ) & 0x3F ) );
+      out += static_cast< char >( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+      out += static_cast< char >( 0x80 | ( cp & 0x3F ) );
+    }
+  }
+
+  // first '"' or '\\' in [ p , end ) , end if none
+  inline const char* find_quote_or_escape( const char *p , const char *end )
+  {
+#ifdef __SSE2__
+    const __m128i q = _mm_set1_epi8( '"' );
+    const __m128i b = _mm_set1_epi8( '\\' );
+    for( ; end - p >= 16; p += 16 )
+    {
+      const __m128i v = _mm_loadu_si128( reinterpret_cast< const __m128i* >( p ) );
+      const int mask = _mm_movemask_epi8( _mm_or_si128( _mm_cmpeq_epi8( v , q ) , _mm_cmpeq_epi8( v , b ) ) );
+      if( mask ){ return p + __builtin_ctz( mask ); }
+    }
+#endif
+    for( ; p != end; ++p )
+    {
+      if( *p == '"' || *p == '\\' ){ return p; }
+    }
+    return end;
+  }
+
+  // decodes the string whose opening quote is at @p into @out ,
+  // returns the position after the closing quote, null on error
+  inline const char* parse_string( const char *p , const char *end , std::string& out )
+  {
+    out.clear();
+    ++p;
+    while( true )
+    {
+      const char *q = find_quote_or_escape( p , end );
+      out.append( p , q );
+      if( q == end ){ return nullptr; }
+      if( *q == '"' ){ return q + 1; }
+
+      // escape
+      if( end - q < 2 ){ return nullptr; }
+      p = q + 2;
+      switch( q[ 1 ] )
+      {
+      case 'b': out += '\b'; break;
+      case 'f': out += '\f'; break;
+      case 'n': out += '\n'; break;
+      case 'r': out += '\r'; break;
+      case 't': out += '\t'; break;
+      case 'u':
+        {
+          auto read4 = [ & ]( const char *h , std::uint32_t& cp )
+          {
+            if( end - h < 4 ){ return false; }
+            cp = 0;
+            for( int i = 0; i < 4; ++i )
+            {
+              const int v = hex_value( h[ i ] );
+              if( v < 0 ){ return false; }
+              cp = cp << 4 | static_cast< std::uint32_t >( v );
+            }
+            return true;
+          };
+          std::uint32_t cp;
+          if( read4( p , cp ) == false ){ return nullptr; }
+          p += 4;
+          // surrogate pair
+          std::uint32_t low;
+          if( cp >= 0xD800 && cp < 0xDC00 && end - p >= 6 && p[ 0 ] == '\\' && p[ 1 ] == 'u' &&
+              read4( p + 2 , low ) && low >= 0xDC00 && low < 0xE000 )
+          {
+            cp = 0x10000 + ( ( cp - 0xD800 ) << 10 ) + ( low - 0xDC00 );
+            p += 6;
+          }
+          append_utf8( out , cp );
+        }
+        break;
+      default:
+        // \" \\ \/ , and anything else stands for itself
+        out += q[ 1 ];
+        break;
+      }
+    }
+  }
+
+  inline bool is_delimiter( char c )
+  {
+    switch( c )
+    {
+    case ' ': case '\t': case '\n': case '\r':
+    case ',': case ':': case '}': case ']': case '{': case '[':
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  // number starting at @p , returns the position after it, null on error.
+  // a mantissa below 2^53 with a power of ten up to 22 is converted exactly
+  // with one multiply or divide, the rest of the checked span goes through
+  // std::from_chars , which does not depend on the locale.
+  inline const char* parse_number( const char *p , const char *end , json_number_t& out )
+  {
+    static const double pow10[] = {
+      1e0 , 1e1 , 1e2 , 1e3 , 1e4 , 1e5 , 1e6 , 1e7 , 1e8 , 1e9 , 1e10 , 1e11 ,
+      1e12 , 1e13 , 1e14 , 1e15 , 1e16 , 1e17 , 1e18 , 1e19 , 1e20 , 1e21 , 1e22
+    };
+    const char *start = p;
+    bool negative = false;
+    if( p != end && ( *p == '-' || *p == '+' ) )
+    {
+      negative = *p == '-';
+      ++p;
+    }
+    std::uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool any = false;
+    for( ; p != end && *p >= '0' && *p <= '9'; ++p )
+    {
+      any = true;
+      if( digits < 19 )
+      {
+        mantissa = mantissa * 10 + static_cast< unsigned >( *p - '0' );
+        if( mantissa ){ ++digits; }
+      }else
+      {
+        ++exponent;
+        digits = 20;
+      }
+    }
+    if( p != end && *p == '.' )
+    {
+      ++p;
+      for( ; p != end && *p >= '0' && *p <= '9'; ++p )
+      {
+        any = true;
+        if( digits < 19 )
+        {
+          mantissa = mantissa * 10 + static_cast< unsigned >( *p - '0' );
+          if( mantissa ){ ++digits; }
+          --exponent;
+        }else
+        {
+          digits = 20;
+        }
+      }
+    }
+    if( any == false ){ return nullptr; }
+    if( p != end && ( *p == 'e' || *p == 'E' ) )
+    {
+      const char *e = p + 1;
+      bool eneg = false;
+      if( e != end && ( *e == '-' || *e == '+' ) )
+      {
+        eneg = *e == '-';
+        ++e;
+      }
+      if( e != end && *e >= '0' && *e <= '9' )
+      {
+        int ev = 0;
+        for( ; e != end && *e >= '0' && *e <= '9'; ++e )
+        {
+          if( ev < 100000 ){ ev = ev * 10 + ( *e - '0' ); }
+        }
+        exponent += eneg ? -ev : ev;
+        p = e;
+      }
+    }
+    if( p != end && is_delimiter( *p ) == false ){ return nullptr; }
+    if( digits <= 19 )
+    {
+      if( mantissa == 0 )
+      {
+        out = negative ? -0.0 : 0.0;
+        return p;
+      }
+      if( mantissa < ( std::uint64_t( 1 ) << 53 ) && exponent >= -22 && exponent <= 22 )
+      {
+        double v = static_cast< double >( mantissa );
+        v = exponent < 0 ? v / pow10[ -exponent ] : v * pow10[ exponent ];
+        out = negative ? -v : v;
+        return p;
+      }
+    }
+
+    // long mantissas, large exponents : the digits scanned above , sign excepted
+    const char *digits_begin = start + ( *start == '-' || *start == '+' );
+    double v = 0;
+    const std::from_chars_result r = std::from_chars( digits_begin , p , v );
+    if( r.ec == std::errc::result_out_of_range )
+    {
+      v = exponent > 0 ? HUGE_VAL : 0.0;
+    }else if( r.ec != std::errc() || r.ptr != p )
+    {
+      return nullptr;
+    }
+    out = negative ? -v : v;
+    return p;
+  }
+
+  inline bool match_literal( const char *p , const char *end , const char *lit , std::size_t n )
+  {
+    return static_cast< std::size_t >( end - p ) >= n && std::memcmp( p , lit , n ) == 0 &&
+           ( static_cast< std::size_t >( end - p ) == n || is_delimiter( p[ n ] ) );
+  }
+
+  // stage 2 : builds the tree from the structural positions
+  class dom_builder
+  {
+  public:
+    // @in_situ : strings without escapes reference @buf instead of being copied.
+    // @first : index of the value to build , for a subtree
+    dom_builder( const char *buf , std::size_t len , const std::vector< std::uint32_t >& index ,
+                 bool in_situ = false , std::size_t first = 0 ) :
+      buf_( buf ) , end_( buf + len ) , index_( index ) , k_( first ) , in_situ_( in_situ )
+    {
+    }
+
+    // false on malformed input; @consumed is the offset after the value
+    bool build( JsonData& root , std::size_t& consumed )
+    {
+      JsonData *target = &root;
+      stack_.clear();
+
+    value:
+      {
+        const char c = peek();
+        switch( c )
+        {
+        case '{':
+          target->resetObject();
+          stack_.push_back( target );
+          ++k_;
+          if( peek() == '}' )
+          {
+            ++k_;
+            stack_.pop_back();
+            goto end_value;
+          }
+          goto object_member;
+        case '[':
+          target->resetArray();
+          stack_.push_back( target );
+          ++k_;
+          if( peek() == ']' )
+          {
+            ++k_;
+            stack_.pop_back();
+            goto end_value;
+          }
+          goto array_element;
+        case ',': case '}': case ']': case 0:
+          // missing value , null
+          target->reset();
+          goto end_value;
+        case ':':
+          return false;
+        case '"':
+          {
+            if( in_situ_ )
+            {
+              const char *p = buf_ + index_[ k_ ] + 1;
+              const char *q = find_quote_or_escape( p , end_ );
+              if( q != end_ && *q == '"' )
+              {
+                target->resetStringView( std::string_view( p , q - p ) );
+                ++k_;
+                goto end_value;
+              }
+            }
+            const char *next = parse_string( buf_ + index_[ k_ ] , end_ , string_ );
+            if( next == nullptr ){ return false; }
+            target->resetString( string_.data() , string_.size() );
+            ++k_;
+            goto end_value;
+          }
+        default:
+          if( scalar( *target ) == false ){ return false; }
+          ++k_;
+          goto end_value;
+        }
+      }
+
+    object_member:
+      {
+        if( peek() != '"' ){ return false; }
+        if( parse_string( buf_ + index_[ k_ ] , end_ , string_ ) == nullptr ){ return false; }
+        ++k_;
+        if( peek() != ':' ){ return false; }
+        ++k_;
+        target = &stack_.back()->getObject()[ string_ ];
+        goto value;
+      }
+
+    array_element:
+      {
+        json_array_t& array = stack_.back()->getArray();
+        array.emplace_back();
+        target = &array.back();
+        goto value;
+      }
+
+    end_value:
+      {
+        if( stack_.empty() )
+        {
+          consumed = k_ < index_.size() ? index_[ k_ ] : end_ - buf_;
+          return true;
+        }
+        const char c = peek();
+        const bool object = stack_.back()->getType() == object_type;
+        if( c == ',' )
+        {
+          ++k_;
+          if( object ){ goto object_member; }
+          goto array_element;
+        }
+        if( c == ( object ? '}' : ']' ) )
+        {
+          ++k_;
+          stack_.pop_back();
+          goto end_value;
+        }
+        return false;
+      }
+    }
+
+  protected:
+    const char *buf_;
+    const char *end_;
+    const std::vector< std::uint32_t >& index_;
+    std::size_t k_;
+    bool in_situ_;
+
+    // containers being filled , innermost last
+    std::vector< JsonData* > stack_;
+    // reused for keys and string values
+    std::string string_;
+
+    char peek() const
+    {
+      return k_ < index_.size() ? buf_[ index_[ k_ ] ] : 0;
+    }
+
+    bool scalar( JsonData& out )
+    {
+      const char *p = buf_ + index_[ k_ ];
+      if( match_literal( p , end_ , "true" , 4 ) )
+      {
+        out.resetBool( true );
+        return true;
+      }
+      if( match_literal( p , end_ , "false" , 5 ) )
+      {
+        out.resetBool( false );
+        return true;
+      }
+      if( match_literal( p , end_ , "null" , 4 ) )
+      {
+        out.reset();
+        return true;
+      }
+      json_number_t v;
+      if( parse_number( p , end_ , v ) == nullptr ){ return false; }
+      out.resetNumber( v );
+      return true;
+    }
+  };
+
+  // contiguous character storage , parsed in place
+  template < typename IterType >
+  struct is_contiguous :
+    std::integral_constant< bool ,
+      std::is_pointer< IterType >::value ||
+      std::is_same< IterType , std::string::iterator >::value ||
+      std::is_same< IterType , std::string::const_iterator >::value ||
+      std::is_same< IterType , std::vector< char >::iterator >::value ||
+      std::is_same< IterType , std::vector< char >::const_iterator >::value >
+  {
+  };
+
+  // parses the value at the start of [ buf , buf + len ) ,
+  // returns the offset after it ( and trailing whitespace ) in @consumed
+  // @index is scratch space , reusable across calls
+  inline bool parse_buffer( const char *buf , std::size_t len , JsonData& out , std::size_t& consumed ,
+                            std::vector< std::uint32_t >& index , bool in_situ = false )
+  {
+    if( len > max_length )
+    {
+      out.reset();
+      consumed = 0;
+      return false;
+    }
+    index_structurals( buf , len , index );
+    dom_builder builder( buf , len , index , in_situ );
+    if( builder.build( out , consumed ) == false )
+    {
+      out.reset();
+      consumed = 0;
+      return false;
+    }
+    return true;
+  }
+
+  inline bool parse_buffer( const char *buf , std::size_t len , JsonData& out , std::size_t& consumed )
+  {
+    std::vector< std::uint32_t > index;
+    return parse_buffer( buf , len , out , consumed , index );
+  }
+
+  template < typename IterType >
+  inline bool parse_range( IterType begin , IterType end , JsonData& out , std::size_t& consumed ,
+                           std::vector< std::uint32_t >& index , std::true_type )
+  {
+    const std::size_t len = static_cast< std::size_t >( std::distance( begin , end ) );
+    return parse_buffer( len ? &*begin : "" , len , out , consumed , index );
+  }
+  template < typename IterType >
+  inline bool parse_range( IterType begin , IterType end , JsonData& out , std::size_t& consumed ,
+                           std::vector< std::uint32_t >& index , std::false_type )
+  {
+    const std::string copy( begin , end );
+    return parse_buffer( copy.data() , copy.size() , out , consumed , index );
+  }
+}
+
+template < typename IterType >
+static
+JsonData parse( IterType begin , IterType end , bool *boolptr = nullptr )
+{
+  JsonData ret;
+  std::size_t consumed;
+  std::vector< std::uint32_t > index;
+  const bool bret = parser::parse_range( begin , end , ret , consumed , index , parser::is_contiguous< IterType >() );
+  if( boolptr )
+  {
+    *boolptr = bret;
+  }
+  return ret;
+}
+// @begin is moved past the parsed value
+template < typename IterType >
+static
+JsonData parse( IterType& begin , IterType end , bool *boolptr = nullptr )
+{
+  JsonData ret;
+  std::size_t consumed;
+  std::vector< std::uint32_t > index;
+  const bool bret = parser::parse_range( begin , end , ret , consumed , index , parser::is_contiguous< IterType >() );
+  if( bret )
+  {
+    std::advance( begin , consumed );
+  }
+  if( boolptr )
+  {
+    *boolptr = bret;
+  }
+  return ret;
+}
+
+// in-situ parse : string values without escapes are string_views into
+// [ begin , end ) instead of copies ( JsonData::getStringView ).
+// the buffer has to outlive the returned tree , or at least every read of
+// its strings; getString() or a copy of the tree detaches a string from it
+inline
+JsonData parse_in_situ( const char *begin , const char *end , bool *boolptr = nullptr )
+{
+  JsonData ret;
+  std::size_t consumed;
+  std::vector< std::uint32_t > index;
+  const bool bret = parser::parse_buffer( begin , end - begin , ret , consumed , index , true );
+  if( boolptr )
+  {
+    *boolptr = bret;
+  }
+  return ret;
+}
+
+}}
@@ -0,0 +1,332 @@
+#pragma once
+
+#include "json.hpp"
+#include "document.hpp"
+#include "lazy.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace eh { namespace json {
+
+// one step of a compiled path. whether it is an object key or an array
+// index is decided by the value it is applied to , as in JSON Pointer
+struct path_step
+{
+  static constexpr std::uint32_t no_index = ~std::uint32_t( 0 );
+
+  // the decoded key , within the path's characters
+  std::uint32_t offset = 0;
+  std::uint32_t size = 0;
+  // key_hash of the key
+  std::uint32_t hash = 0;
+  // the key read as an array index , no_index if it is not one
+  std::uint32_t index = no_index;
+};
+
+namespace pointer
+{
+  // decimal without leading zeros , as JSON Pointer requires
+  constexpr std::uint32_t array_index( const char *s , std::size_t n )
+  {
+    if( n == 0 || n > 9 || ( n > 1 && s[ 0 ] == '0' ) )
+    {
+      return path_step::no_index;
+    }
+    std::uint32_t i = 0;
+    for( std::size_t k = 0; k < n; ++k )
+    {
+      if( s[ k ] < '0' || s[ k ] > '9' ){ return path_step::no_index; }
+      i = i * 10 + ( s[ k ] - '0' );
+    }
+    return i;
+  }
+
+  // splits the JSON Pointer @str ( "/a/b/3" , "~0" for '~' and "~1" for '/' ) into
+  // @steps , decoding the keys into @chars. both need room for @n entries.
+  // false if @str is not a pointer
+  constexpr bool compile( const char *str , std::size_t n , char *chars , path_step *steps , std::size_t& count )
+  {
+    count = 0;
+    if( n == 0 ){ return true; }
+    if( str[ 0 ] != '/' ){ return false; }
+    std::size_t out = 0;
+    std::size_t i = 1;
+    while( true )
+    {
+      path_step& s = steps[ count++ ];
+      s.offset = static_cast< std::uint32_t >( out );
+      for( ; i < n && str[ i ] != '/'; ++i )
+      {
+        char c = str[ i ];
+        if( c == '~' )
+        {
+          if( i + 1 == n || ( str[ i + 1 ] != '0' && str[ i + 1 ] != '1' ) ){ return false; }
+          c = str[ ++i ] == '0' ? '~' : '/';
+        }
+        chars[ out++ ] = c;
+      }
+      s.size = static_cast< std::uint32_t >( out - s.offset );
+      s.hash = key_hash( chars + s.offset , s.size );
+      s.index = array_index( chars + s.offset , s.size );
+      if( i == n ){ return true; }
+      ++i;
+    }
+  }
+
+  inline const JsonData& root_of( const JsonData& value )
+  {
+    return value;
+  }
+  inline const JsonData& root_of( const document& doc )
+  {
+    return doc.root();
+  }
+
+  // @key_of( i ) : the interned key of step i , only asked for on objects
+  template < typename KeyOf >
+  const JsonData* evaluate( const JsonData& root , const path_step *steps , std::size_t count , KeyOf key_of )
+  {
+    const JsonData *v = &root;
+    for( std::size_t i = 0; i < count; ++i )
+    {
+      const path_step& s = steps[ i ];
+      if( v->getType() == object_type )
+      {
+        const json_object_t& object = v->getObject();
+        const auto it = object.find( key_of( i ) );
+        if( it == object.end() ){ return nullptr; }
+        v = &it->second;
+      }else if( v->getType() == array_type )
+      {
+        const json_array_t& array = v->getArray();
+        if( s.index >= array.size() ){ return nullptr; }
+        v = &array[ s.index ];
+      }else
+      {
+        return nullptr;
+      }
+    }
+    return v;
+  }
+
+  inline lazy_value evaluate( lazy_value v , const char *chars , const path_step *steps , std::size_t count )
+  {
+    for( std::size_t i = 0; i < count && v.valid(); ++i )
+    {
+      const path_step& s = steps[ i ];
+      const type_type type = v.getType();
+      if( type == object_type )
+      {
+        v = v[ std::string_view( chars + s.offset , s.size ) ];
+      }else if( type == array_type && s.index != path_step::no_index )
+      {
+        v = v[ static_cast< std::size_t >( s.index ) ];
+      }else
+      {
+        return lazy_value();
+      }
+    }
+    return v;
+  }
+}
+
+// a JSON Pointer compiled at compile time :
+//
+//  static constexpr static_path price( "/order/items/0/price" );
+//  if( const JsonData *v = price.find( doc.root() ) ){ ... }
+//
+// keys are hashed by the compiler; a lookup only probes the key table and
+// compares key ids. nothing is inserted or allocated , a missing member or
+// element gives null.
+template < std::size_t N >
+class static_path
+{
+public:
+  constexpr explicit static_path( const char ( &str )[ N ] )
+  {
+    valid_ = pointer::compile( str , N - 1 , chars_ , steps_ , count_ );
+  }
+
+  // false if the string was not a JSON Pointer; such a path finds nothing
+  constexpr bool valid() const
+  {
+    return valid_;
+  }
+  constexpr std::size_t size() const
+  {
+    return count_;
+  }
+  constexpr const path_step& operator [] ( std::size_t i ) const
+  {
+    return steps_[ i ];
+  }
+  constexpr std::string_view name( std::size_t i ) const
+  {
+    return std::string_view( chars_ + steps_[ i ].offset , steps_[ i ].size );
+  }
+
+  const JsonData* find( const JsonData& root ) const
+  {
+    if( valid_ == false ){ return nullptr; }
+    return pointer::evaluate( root , steps_ , count_ , [ this ]( std::size_t i ){ return resolve( i ); } );
+  }
+  lazy_value find( lazy_value root ) const
+  {
+    return valid_ ? pointer::evaluate( root , chars_ , steps_ , count_ ) : lazy_value();
+  }
+
+  // the value at the path in each of [ begin , end ) ( JsonData or document ),
+  // written to @out , null where missing. keys are resolved once for the
+  // whole batch. returns how many were found
+  template < typename Iter , typename Out >
+  std::size_t find_all( Iter begin , Iter end , Out out ) const
+  {
+    key keys[ N ];
+    for( std::size_t i = 0; i < count_; ++i )
+    {
+      keys[ i ] = resolve( i );
+    }
+    std::size_t found = 0;
+    for( ; begin != end; ++begin )
+    {
+      const JsonData *v = valid_ ? pointer::evaluate( pointer::root_of( *begin ) , steps_ , count_ ,
+                                                      [ &keys ]( std::size_t i ){ return keys[ i ]; } ) : nullptr;
+      found += v != nullptr;
+      *out++ = v;
+    }
+    return found;
+  }
+  // over the elements of the array @docs
+  template < typename Out >
+  std::size_t find_all( const JsonData& docs , Out out ) const
+  {
+    if( docs.getType() != array_type ){ return 0; }
+    const json_array_t& array = docs.getArray();
+    return find_all( array.begin() , array.end() , out );
+  }
+
+protected:
+  char chars_[ N ] = {};
+  path_step steps_[ N ] = {};
+  std::size_t count_ = 0;
+  bool valid_ = false;
+
+  // the null key if no document ever had it
+  key resolve( std::size_t i ) const
+  {
+    return key_table::global().find( name( i ) , steps_[ i ].hash );
+  }
+};
+
+// a JSON Pointer compiled at run time. like static_path its keys are only
+// looked up in the key table , never interned : paths built from client
+// input ( below ) do not grow the process wide table. evaluation never
+// inserts or allocates.
+//
+//  const path p( request.field );
+//  for( const auto& doc : docs ){ if( const JsonData *v = p.find( doc.root() ) ){ ... } }
+class path
+{
+public:
+  path() = default;
+  explicit path( std::string_view str )
+  {
+    chars_.resize( str.size() );
+    steps_.resize( str.size() );
+    std::size_t count;
+    valid_ = pointer::compile( str.data() , str.size() , &chars_[ 0 ] , steps_.data() , count );
+    steps_.resize( valid_ ? count : 0 );
+  }
+  template < std::size_t N >
+  explicit path( const static_path< N >& rhs ) :
+    valid_( rhs.valid() )
+  {
+    for( std::size_t i = 0; i < rhs.size(); ++i )
+    {
+      path_step s = rhs[ i ];
+      s.offset = static_cast< std::uint32_t >( chars_.size() );
+      chars_.append( rhs.name( i ) );
+      steps_.push_back( s );
+    }
+  }
+
+  bool valid() const
+  {
+    return valid_;
+  }
+  std::size_t size() const
+  {
+    return steps_.size();
+  }
+  const path_step& operator [] ( std::size_t i ) const
+  {
+    return steps_[ i ];
+  }
+  std::string_view name( std::size_t i ) const
+  {
+    return std::string_view( chars_.data() + steps_[ i ].offset , steps_[ i ].size );
+  }
+
+  const JsonData* find( const JsonData& root ) const
+  {
+    if( valid_ == false ){ return nullptr; }
+    return pointer::evaluate( root , steps_.data() , steps_.size() , [ this ]( std::size_t i ){ return resolve( i ); } );
+  }
+  lazy_value find( lazy_value root ) const
+  {
+    return valid_ ? pointer::evaluate( root , chars_.data() , steps_.data() , steps_.size() ) : lazy_value();
+  }
+
+  // see static_path::find_all. keys are resolved once for the batch when
+  // the path has at most batch_steps steps , per document otherwise
+  template < typename Iter , typename Out >
+  std::size_t find_all( Iter begin , Iter end , Out out ) const
+  {
+    const bool batch = steps_.size() <= batch_steps;
+    key keys[ batch_steps ];
+    for( std::size_t i = 0; batch && i < steps_.size(); ++i )
+    {
+      keys[ i ] = resolve( i );
+    }
+    std::size_t found = 0;
+    for( ; begin != end; ++begin )
+    {
+      const JsonData *v = nullptr;
+      if( valid_ )
+      {
+        v = batch ? pointer::evaluate( pointer::root_of( *begin ) , steps_.data() , steps_.size() ,
+                                       [ &keys ]( std::size_t i ){ return keys[ i ]; } )
+                  : find( pointer::root_of( *begin ) );
+      }
+      found += v != nullptr;
+      *out++ = v;
+    }
+    return found;
+  }
+  template < typename Out >
+  std::size_t find_all( const JsonData& docs , Out out ) const
+  {
+    if( docs.getType() != array_type ){ return 0; }
+    const json_array_t& array = docs.getArray();
+    return find_all( array.begin() , array.end() , out );
+  }
+
+protected:
+  static constexpr std::size_t batch_steps = 16;
+
+  std::string chars_;
+  std::vector< path_step > steps_;
+  bool valid_ = true;
+
+  // the null key if no document ever had it
+  key resolve( std::size_t i ) const
+  {
+    return key_table::global().find( name( i ) , steps_[ i ].hash );
+  }
+};
+
+}}
@@ -15,7 +15,7 @@ std::ostream& operator << ( std::ostream& stream , JsonData const& data )
     data.array_stream_out( stream );
     break;
   case string_type:
-    stream << '"' << data.getString() << '"';
+    stream << '"' << data.getStringView() << '"';
     break;
   case int_type:
     stream << data.getInt();
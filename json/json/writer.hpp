@@ -0,0 +1,292 @@
+#pragma once
+
+#include "json.hpp"
+
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace eh { namespace json {
+
+// serializer writing straight into a string buffer.
+//
+// numbers are printed shortest round trip : integral values through a two
+// digit table , the others through std::to_chars ( Ryu in libstdc++ ).
+// NaN and infinities have no JSON form and are written as null.
+// strings are escaped , with runs needing no escape found 16 bytes at a time
+// and copied in one go; bytes above 0x7f pass through as they are.
+//
+//  std::string out;
+//  serialize( doc.root() , out );      // {"a":[1,2.5]}
+//  serialize( doc.root() , out , 2 );  // pretty , two spaces per level
+namespace writer
+{
+  constexpr char digit_pairs[] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+  // writes @v at @out , returns the end. needs 20 bytes
+  inline char* format_uint( char *out , std::uint64_t v )
+  {
+    char buf[ 20 ];
+    char *p = buf + sizeof( buf );
+    while( v >= 100 )
+    {
+      const unsigned r = static_cast< unsigned >( v % 100 );
+      v /= 100;
+      p -= 2;
+      std::memcpy( p , digit_pairs + r * 2 , 2 );
+    }
+    if( v >= 10 )
+    {
+      p -= 2;
+      std::memcpy( p , digit_pairs + v * 2 , 2 );
+    }else
+    {
+      *--p = static_cast< char >( '0' + v );
+    }
+    const std::size_t n = buf + sizeof( buf ) - p;
+    std::memcpy( out , p , n );
+    return out + n;
+  }
+  // needs 21 bytes
+  inline char* format_int( char *out , std::int64_t v )
+  {
+    if( v < 0 )
+    {
+      *out++ = '-';
+      return format_uint( out , 0 - static_cast< std::uint64_t >( v ) );
+    }
+    return format_uint( out , static_cast< std::uint64_t >( v ) );
+  }
+  // shortest text reading back as @d , needs 32 bytes
+  inline char* format_number( char *out , double d )
+  {
+    if( std::isfinite( d ) == false )
+    {
+      std::memcpy( out , "null" , 4 );
+      return out + 4;
+    }
+    // integral values below 2^53 print exactly as integers , -0 excepted :
+    // to_chars writes it as "-0" , which parses back as -0.0 and so equals 0
+    if( std::fabs( d ) < 9007199254740992.0 && d == std::trunc( d ) && ( d != 0 || std::signbit( d ) == false ) )
+    {
+      return format_int( out , static_cast< std::int64_t >( d ) );
+    }
+    return std::to_chars( out , out + 32 , d ).ptr;
+  }
+
+  // first character of [ p , end ) that needs an escape : '"' , '\\' or a control character
+  inline const char* find_escape( const char *p , const char *end )
+  {
+#ifdef __SSE2__
+    const __m128i q = _mm_set1_epi8( '"' );
+    const __m128i b = _mm_set1_epi8( '\\' );
+    const __m128i c = _mm_set1_epi8( 0x1f );
+    for( ; end - p >= 16; p += 16 )
+    {
+      const __m128i v = _mm_loadu_si128( reinterpret_cast< const __m128i* >( p ) );
+      // unsigned v <= 0x1f
+      const __m128i control = _mm_cmpeq_epi8( _mm_min_epu8( v , c ) , v );
+      const int mask = _mm_movemask_epi8( _mm_or_si128( _mm_or_si128( _mm_cmpeq_epi8( v , q ) , _mm_cmpeq_epi8( v , b ) ) ,
+                                                        control ) );
+      if( mask ){ return p + __builtin_ctz( mask ); }
+    }
+#endif
+    for( ; p != end; ++p )
+    {
+      const unsigned char u = static_cast< unsigned char >( *p );
+      if( u == '"' || u == '\\' || u < 0x20 ){ return p; }
+    }
+    return end;
+  }
+
+  class serializer
+  {
+  public:
+    // appends to @out; @indent spaces per level , 0 : compact
+    explicit serializer( std::string& out , unsigned indent = 0 ) :
+      out_( out ) ,
+      pos_( out.size() ) ,
+      indent_( indent ) ,
+      depth_( 0 )
+    {
+    }
+    ~serializer()
+    {
+      out_.resize( pos_ );
+    }
+    serializer( const serializer& ) = delete;
+    serializer& operator = ( const serializer& ) = delete;
+
+    void value( const JsonData& data )
+    {
+      switch( data.getType() )
+      {
+      case object_type:
+        object( data.getObject() );
+        break;
+      case array_type:
+        array( data.getArray() );
+        break;
+      case string_type:
+        string( data.getStringView() );
+        break;
+      case int_type:
+        pos_ = format_int( room( 21 ) , data.getInt() ) - out_.data();
+        break;
+      case number_type:
+        pos_ = format_number( room( 32 ) , data.getNumber() ) - out_.data();
+        break;
+      case bool_type:
+        data.getBool() ? raw( "true" , 4 ) : raw( "false" , 5 );
+        break;
+      default:
+        raw( "null" , 4 );
+        break;
+      }
+    }
+
+    void string( std::string_view str )
+    {
+      const char *p = str.data();
+      const char *end = p + str.size();
+      char *out = room( str.size() + 2 );
+      *out++ = '"';
+      while( true )
+      {
+        const char *q = find_escape( p , end );
+        std::memcpy( out , p , q - p );
+        out += q - p;
+        if( q == end ){ break; }
+
+        // an escape is at most 6 bytes , then the rest and the closing quote
+        pos_ = out - out_.data();
+        out = room( 6 + ( end - q ) + 1 );
+        *out++ = '\\';
+        switch( *q )
+        {
+        case '"': *out++ = '"'; break;
+        case '\\': *out++ = '\\'; break;
+        case '\b': *out++ = 'b'; break;
+        case '\f': *out++ = 'f'; break;
+        case '\n': *out++ = 'n'; break;
+        case '\r': *out++ = 'r'; break;
+        case '\t': *out++ = 't'; break;
+        default:
+          std::memcpy( out , "u00" , 3 );
+          out[ 3 ] = "0123456789abcdef"[ *q >> 4 ];
+          out[ 4 ] = "0123456789abcdef"[ *q & 0xf ];
+          out += 5;
+          break;
+        }
+        p = q + 1;
+      }
+      *out++ = '"';
+      pos_ = out - out_.data();
+    }
+
+  protected:
+    std::string& out_;
+    // end of the written text; out_ is longer while writing
+    std::size_t pos_;
+    unsigned indent_;
+    unsigned depth_;
+
+    // @n writable bytes at pos_
+    char* room( std::size_t n )
+    {
+      if( out_.size() - pos_ < n )
+      {
+        out_.resize( std::max( out_.size() * 2 , pos_ + n + 64 ) );
+      }
+      return &out_[ pos_ ];
+    }
+    void raw( const char *s , std::size_t n )
+    {
+      std::memcpy( room( n ) , s , n );
+      pos_ += n;
+    }
+    void newline()
+    {
+      if( indent_ == 0 ){ return; }
+      const std::size_t n = 1 + std::size_t( indent_ ) * depth_;
+      char *out = room( n );
+      out[ 0 ] = '\n';
+      std::memset( out + 1 , ' ' , n - 1 );
+      pos_ += n;
+    }
+
+    void object( const json_object_t& object )
+    {
+      if( object.empty() )
+      {
+        raw( "{}" , 2 );
+        return;
+      }
+      raw( "{" , 1 );
+      ++depth_;
+      bool first = true;
+      for( const auto& member : object )
+      {
+        if( first == false ){ raw( "," , 1 ); }
+        first = false;
+        newline();
+        string( member.first );
+        indent_ ? raw( ": " , 2 ) : raw( ":" , 1 );
+        value( member.second );
+      }
+      --depth_;
+      newline();
+      raw( "}" , 1 );
+    }
+    void array( const json_array_t& array )
+    {
+      if( array.empty() )
+      {
+        raw( "[]" , 2 );
+        return;
+      }
+      raw( "[" , 1 );
+      ++depth_;
+      bool first = true;
+      for( const JsonData& element : array )
+      {
+        if( first == false ){ raw( "," , 1 ); }
+        first = false;
+        newline();
+        value( element );
+      }
+      --depth_;
+      newline();
+      raw( "]" , 1 );
+    }
+  };
+}
+
+// appends @data to @out , compact or with @indent spaces per level.
+// @out keeps its capacity , so a reused buffer stops allocating
+inline void serialize( const JsonData& data , std::string& out , unsigned indent = 0 )
+{
+  writer::serializer s( out , indent );
+  s.value( data );
+}
+inline std::string serialize( const JsonData& data , unsigned indent = 0 )
+{
+  std::string out;
+  serialize( data , out , indent );
+  return out;
+}
+
+}}
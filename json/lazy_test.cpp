@@ -0,0 +1,72 @@
+// lazy_document::parse() must accept exactly the single well formed values.
+// exits with 1 and lists the offending inputs otherwise.
+//
+//  g++ -std=c++17 lazy_test.cpp && ./a.out
+#include <iostream>
+#include <string>
+#include "json.hpp"
+
+namespace
+{
+  bool parses( const std::string& text )
+  {
+    eh::json::lazy_document doc;
+    return doc.parse( text.data() , text.data() + text.size() );
+  }
+}
+
+int main()
+{
+  const char *good[] =
+  {
+    "[\"a\",1]" ,
+    "{\"a\":\"b\",\"c\":null}" ,
+    "[\"a\" , true]" ,
+    "[\"x\\\"y\",-1.5e3]" ,
+    "{}" ,
+    "[[],{}]" ,
+  };
+  const char *bad[] =
+  {
+    // a scalar glued to a string
+    "[\"a\"1]" ,
+    "{\"a\":\"b\"c}" ,
+    "[\"a\"true]" ,
+    "{\"a\":\"b\"null,\"c\":1}" ,
+    "{\"k\"1:2}" ,
+    // structure
+    "[1,]" ,
+    "{\"a\" 1}" ,
+    "[1 2]" ,
+    "[\"open]" ,
+    "" ,
+  };
+
+  int failures = 0;
+  for( const char *text : good )
+  {
+    if( parses( text ) == false )
+    {
+      std::cout << "rejected : " << text << std::endl;
+      ++failures;
+    }
+  }
+  for( const char *text : bad )
+  {
+    // also with the glued token straddling a 64 byte stage 1 block
+    for( std::size_t pad = 0; pad < 70; ++pad )
+    {
+      // "[ ]" is well formed
+      if( pad && *text == 0 ){ break; }
+      const std::string padded = pad ? "[" + std::string( pad , ' ' ) + text + "]" : std::string( text );
+      if( parses( padded ) )
+      {
+        std::cout << "accepted : " << padded << std::endl;
+        ++failures;
+        break;
+      }
+    }
+  }
+  std::cout << ( failures ? "FAILED" : "ok" ) << std::endl;
+  return failures ? 1 : 0;
+}
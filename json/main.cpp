@@ -1,8 +1,6 @@
 #include <iostream>
 #include "json.hpp"
 
-using namespace boost::spirit;
-
 
 int main()
 {
@@ -0,0 +1,170 @@
+// parse() must build the same tree as the X3 reference grammar ( parse_x3 )
+// on well formed input , and reject malformed input the grammar lets through.
+// exits with 1 and lists the offending inputs otherwise.
+//
+//  g++ -std=c++17 parser_test.cpp && ./a.out      ( needs Boost.Spirit )
+#include <iostream>
+#include <random>
+#include <string>
+#include <cmath>
+#include <cstdio>
+#include "json.hpp"
+#include "json/grammar.hpp"
+
+namespace
+{
+  using namespace eh::json;
+
+  std::mt19937 rng( 7 );
+
+  bool same( const JsonData& a , const JsonData& b )
+  {
+    if( a.getType() != b.getType() ){ return false; }
+    switch( a.getType() )
+    {
+    case object_type:
+    {
+      const json_object_t& x = a.getObject();
+      const json_object_t& y = b.getObject();
+      if( x.size() != y.size() ){ return false; }
+      for( const auto& member : x )
+      {
+        const auto it = y.find( member.first );
+        if( it == y.end() || same( member.second , it->second ) == false ){ return false; }
+      }
+      return true;
+    }
+    case array_type:
+    {
+      const json_array_t& x = a.getArray();
+      const json_array_t& y = b.getArray();
+      if( x.size() != y.size() ){ return false; }
+      for( std::size_t i = 0; i < x.size(); ++i )
+      {
+        if( same( x[ i ] , y[ i ] ) == false ){ return false; }
+      }
+      return true;
+    }
+    case string_type:
+      return a.getStringView() == b.getStringView();
+    case number_type:
+      // x3::double_ is not always correctly rounded
+      return std::fabs( a.getNumber() - b.getNumber() ) <= 1e-15 * std::fabs( a.getNumber() );
+    case bool_type:
+      return a.getBool() == b.getBool();
+    default:
+      return true;
+    }
+  }
+
+  std::string space()
+  {
+    static const char *spaces[] = { "" , " " , "  " , "\n" , "\t " , " \r\n" };
+    return spaces[ rng() % 6 ];
+  }
+  std::string number()
+  {
+    char buf[ 64 ];
+    switch( rng() % 6 )
+    {
+    case 0:
+      std::snprintf( buf , sizeof( buf ) , "%d" , static_cast< int >( rng() ) - static_cast< int >( rng() >> 1 ) );
+      break;
+    case 1:
+      std::snprintf( buf , sizeof( buf ) , "%.17g" , std::uniform_real_distribution< double >( -1e6 , 1e6 )( rng ) );
+      break;
+    case 2:
+      std::snprintf( buf , sizeof( buf ) , "%.6e" ,
+                     std::uniform_real_distribution< double >( -1 , 1 )( rng ) * std::pow( 10.0 , int( rng() % 600 ) - 300 ) );
+      break;
+    case 3:
+      std::snprintf( buf , sizeof( buf ) , "%u.%u" , unsigned( rng() % 1000 ) , unsigned( rng() % 1000 ) );
+      break;
+    case 4:
+      std::snprintf( buf , sizeof( buf ) , "12345678901234567890123.5" );
+      break;
+    default:
+      std::snprintf( buf , sizeof( buf ) , "%.3f" , std::uniform_real_distribution< double >( -100 , 100 )( rng ) );
+      break;
+    }
+    return buf;
+  }
+  std::string quoted()
+  {
+    // no spaces : the grammar skips them inside strings
+    static const char chars[] = "abcdefghijklmnopqrstuvwxyz{},:[]";
+    std::string s = "\"";
+    for( unsigned n = rng() % 12; n; --n )
+    {
+      s += chars[ rng() % ( sizeof( chars ) - 1 ) ];
+    }
+    return s + "\"";
+  }
+  std::string value( int depth )
+  {
+    switch( rng() % ( depth > 4 ? 4 : 7 ) )
+    {
+    case 0: return number();
+    case 1: return quoted();
+    case 2: return rng() % 2 ? "true" : "false";
+    case 3: return "null";
+    case 4:
+    {
+      std::string s = "{";
+      for( unsigned i = 0 , n = 1 + rng() % 5; i < n; ++i )
+      {
+        if( i ){ s += space() + ","; }
+        s += space() + quoted() + space() + ":" + space() + value( depth + 1 ) + space();
+      }
+      return s + "}";
+    }
+    default:
+    {
+      std::string s = "[";
+      for( unsigned i = 0 , n = 1 + rng() % 6; i < n; ++i )
+      {
+        if( i ){ s += ","; }
+        s += space() + value( depth + 1 ) + space();
+      }
+      return s + "]";
+    }
+    }
+  }
+}
+
+int main()
+{
+  int failures = 0;
+  for( int i = 0; i < 20000; ++i )
+  {
+    const std::string text = space() + value( 0 ) + space();
+    bool ok , ok_x3;
+    const JsonData a = parse( text.begin() , text.end() , &ok );
+    const JsonData b = parse_x3( text.begin() , text.end() , &ok_x3 );
+    if( ok == false || ok_x3 == false || same( a , b ) == false )
+    {
+      std::cout << "differs : " << text << std::endl;
+      ++failures;
+    }
+  }
+
+  // the grammar accepts a prefix of these
+  const char *bad[] =
+  {
+    "{\"a\" 1}" , "{\"a\":1,}" , "[1 2]" , "{1:2}" , "\"abc" , "[1,2" , "{\"a\":1]" ,
+    "tru" , "-" , "1.5e" , "[nan]" , "[inf]" , "[0x10]" ,
+  };
+  for( const char *text : bad )
+  {
+    const std::string s( text );
+    bool ok;
+    parse( s.begin() , s.end() , &ok );
+    if( ok )
+    {
+      std::cout << "accepted : " << s << std::endl;
+      ++failures;
+    }
+  }
+  std::cout << ( failures ? "FAILED" : "ok" ) << std::endl;
+  return failures ? 1 : 0;
+}
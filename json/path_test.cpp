@@ -0,0 +1,128 @@
+// static_path and path must find what the pointer names , give null for what
+// is missing , and neither insert keys nor allocate while evaluating.
+// exits with 1 and lists the failed checks otherwise.
+//
+//  g++ -std=c++17 path_test.cpp && ./a.out
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <new>
+#include "json.hpp"
+
+namespace
+{
+  long allocations = 0;
+  int failures = 0;
+
+  void check( bool ok , const char *what )
+  {
+    if( ok == false )
+    {
+      std::cout << "failed : " << what << std::endl;
+      ++failures;
+    }
+  }
+}
+
+void* operator new( std::size_t n )
+{
+  ++allocations;
+  if( void *p = std::malloc( n ? n : 1 ) ){ return p; }
+  throw std::bad_alloc();
+}
+void operator delete( void *p ) noexcept
+{
+  std::free( p );
+}
+void operator delete( void *p , std::size_t ) noexcept
+{
+  std::free( p );
+}
+
+using namespace eh::json;
+
+// compiled by the compiler
+static constexpr static_path deep( "/a/b/3/c" );
+static_assert( deep.valid() && deep.size() == 4 , "steps" );
+static_assert( deep[ 2 ].index == 3 && deep[ 0 ].index == path_step::no_index , "array index" );
+static_assert( deep[ 0 ].hash == key_hash( "a" , 1 ) , "key hash" );
+static constexpr static_path escaped( "/x~1y/m~0n" );
+static_assert( escaped.name( 0 ) == "x/y" && escaped.name( 1 ) == "m~n" , "escapes" );
+static_assert( static_path( "a/b" ).valid() == false , "not a pointer" );
+static_assert( static_path( "" ).valid() && static_path( "" ).size() == 0 , "whole document" );
+static_assert( static_path( "/01" )[ 0 ].index == path_step::no_index && static_path( "/0" )[ 0 ].index == 0 , "leading zero" );
+
+int main()
+{
+  const std::string text =
+    R"({"a":{"b":[0,1,2,{"c":42,"x/y":{"m~n":"hi"}}],"7":"seven"},"arr":[{"v":1},{"v":2},{"w":3},5]})";
+  document doc;
+  check( doc.parse( text.begin() , text.end() ) , "parse" );
+  const JsonData& root = static_cast< const document& >( doc ).root();
+
+  const JsonData *v = deep.find( root );
+  check( v && v->getNumber() == 42 , "static_path find" );
+  check( static_path( "" ).find( root ) == &root , "empty pointer is the root" );
+  const path names( "/a/b/3/x~1y/m~0n" );
+  v = names.find( root );
+  check( v && v->getStringView() == "hi" , "path find with escapes" );
+  v = path( "/a/7" ).find( root );
+  check( v && v->getStringView() == "seven" , "digit key on an object" );
+  check( path( "/a/b/9" ).find( root ) == nullptr , "index past the end" );
+  check( path( "/a/b/-" ).find( root ) == nullptr , "'-' index" );
+  check( path( "/a/b/0/z" ).find( root ) == nullptr , "step into a scalar" );
+  check( path( "nope" ).valid() == false && path( "nope" ).find( root ) == nullptr , "invalid path" );
+  check( path( deep ).find( root ) == deep.find( root ) , "path from static_path" );
+
+  // evaluation inserts and allocates nothing , even for keys no document has
+  static constexpr static_path missing( "/a/never_seen_key/q" );
+  const path missing_run( "/a/never_seen_either" );
+  const std::size_t members = root[ "a" ].getObject().size();
+  const std::size_t keys = key_table::global().size();
+  long before = allocations;
+  check( missing.find( root ) == nullptr , "missing static key" );
+  check( missing_run.find( root ) == nullptr , "missing run-time key" );
+  check( deep.find( root ) != nullptr && names.find( root ) != nullptr , "found again" );
+  check( allocations == before , "no allocation in find" );
+  check( root[ "a" ].getObject().size() == members , "no member inserted" );
+  check( key_table::global().size() == keys , "no key interned" );
+
+  // a key first seen after the path was built is still found
+  const path later( "/first_seen_later" );
+  const std::string text2 = R"({"first_seen_later":7})";
+  document doc2;
+  check( doc2.parse( text2.begin() , text2.end() ) , "parse later" );
+  v = later.find( doc2.root() );
+  check( v && v->getNumber() == 7 , "key interned after the path" );
+
+  // lazy documents
+  lazy_document lazy;
+  check( lazy.parse( text.data() , text.data() + text.size() ) , "lazy parse" );
+  check( deep.find( lazy.root() ).getInt() == 42 , "lazy static_path" );
+  std::string scratch;
+  check( names.find( lazy.root() ).getStringView( scratch ) == "hi" , "lazy path" );
+  check( missing.find( lazy.root() ).valid() == false , "lazy missing" );
+
+  // batches
+  static constexpr static_path member( "/v" );
+  const JsonData *out[ 4 ];
+  before = allocations;
+  const std::size_t found = member.find_all( root[ "arr" ] , out );
+  check( allocations == before , "no allocation in find_all" );
+  check( found == 2 && out[ 0 ]->getNumber() == 1 && out[ 1 ]->getNumber() == 2 && out[ 2 ] == nullptr &&
+         out[ 3 ] == nullptr , "find_all over an array" );
+  std::vector< document > docs( 3 );
+  for( std::size_t i = 0; i < docs.size(); ++i )
+  {
+    const std::string t = "{\"v\":" + std::to_string( i ) + "}";
+    docs[ i ].parse( t.begin() , t.end() );
+  }
+  std::vector< const JsonData* > results;
+  check( path( "/v" ).find_all( docs.begin() , docs.end() , std::back_inserter( results ) ) == 3 &&
+         results[ 2 ]->getNumber() == 2 , "find_all over documents" );
+
+  std::cout << ( failures ? "FAILED" : "ok" ) << std::endl;
+  return failures ? 1 : 0;
+}
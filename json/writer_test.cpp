@@ -0,0 +1,123 @@
+// serialize() must write numbers in their shortest round trip form , escape
+// what JSON requires , indent in pretty mode , and read back through parse()
+// as the same tree. exits with 1 and lists the failed checks otherwise.
+//
+//  g++ -std=c++17 writer_test.cpp && ./a.out
+#include <iostream>
+#include <random>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include "json.hpp"
+
+namespace
+{
+  using namespace eh::json;
+
+  int failures = 0;
+
+  void check( const std::string& got , const std::string& expected )
+  {
+    if( got != expected )
+    {
+      std::cout << "wrote " << got << " , expected " << expected << std::endl;
+      ++failures;
+    }
+  }
+  std::string number( double d )
+  {
+    JsonData v;
+    v.resetNumber( d );
+    return serialize( v );
+  }
+  std::string text( const std::string& s )
+  {
+    JsonData v;
+    v = s;
+    return serialize( v );
+  }
+  JsonData read( const std::string& s )
+  {
+    bool ok;
+    JsonData v = parse( s.begin() , s.end() , &ok );
+    if( ok == false )
+    {
+      std::cout << "does not parse : " << s << std::endl;
+      ++failures;
+    }
+    return v;
+  }
+}
+
+int main()
+{
+  // shortest form
+  check( number( 0.1 ) , "0.1" );
+  check( number( 1e300 ) , "1e+300" );
+  check( number( 1.5 ) , "1.5" );
+  check( number( -2.25e-10 ) , "-2.25e-10" );
+  check( number( 5e-324 ) , "5e-324" );
+  check( number( 1.7976931348623157e308 ) , "1.7976931348623157e+308" );
+  check( number( 42 ) , "42" );
+  check( number( -9007199254740991.0 ) , "-9007199254740991" );
+  check( number( 0 ) , "0" );
+  check( number( -0.0 ) , "-0" );
+  check( number( NAN ) , "null" );
+  check( number( INFINITY ) , "null" );
+
+  // every double reads back bit for bit
+  std::mt19937_64 rng( 7 );
+  for( int i = 0; i < 100000; ++i )
+  {
+    const std::uint64_t bits = rng();
+    double d;
+    std::memcpy( &d , &bits , sizeof( d ) );
+    if( std::isfinite( d ) == false ){ continue; }
+    const std::string s = number( d );
+    const double back = read( s ).getNumber();
+    if( std::memcmp( &back , &d , sizeof( d ) ) != 0 )
+    {
+      std::cout << "does not round trip : " << s << std::endl;
+      ++failures;
+    }
+  }
+
+  // escapes
+  check( text( "a\"b\\c" ) , "\"a\\\"b\\\\c\"" );
+  check( text( "\b\f\n\r\t" ) , "\"\\b\\f\\n\\r\\t\"" );
+  check( text( std::string( "\x00\x01\x1f" , 3 ) ) , "\"\\u0000\\u0001\\u001f\"" );
+  check( text( "\x7f/\xc3\xa9" ) , "\"\x7f/\xc3\xa9\"" );
+  // an escape after a 16 byte run
+  check( text( "0123456789abcdef\x02" ) , "\"0123456789abcdef\\u0002\"" );
+  std::string controls;
+  for( char c = 1; c < 0x20; ++c ){ controls += c; }
+  check( std::string( read( text( controls ) ).getStringView() ) , controls );
+
+  // compact and pretty
+  const std::string doc = R"({"a":[1,2.5,"x"],"b":{},"c":[],"d":{"e":null,"f":true}})";
+  check( serialize( read( doc ) ) , doc );
+  check( serialize( read( doc ) , 2 ) ,
+         "{\n"
+         "  \"a\": [\n"
+         "    1,\n"
+         "    2.5,\n"
+         "    \"x\"\n"
+         "  ],\n"
+         "  \"b\": {},\n"
+         "  \"c\": [],\n"
+         "  \"d\": {\n"
+         "    \"e\": null,\n"
+         "    \"f\": true\n"
+         "  }\n"
+         "}" );
+  check( serialize( read( serialize( read( doc ) , 4 ) ) ) , doc );
+
+  // appends to what the buffer holds
+  std::string out = "x=";
+  serialize( read( "[1]" ) , out );
+  check( out , "x=[1]" );
+
+  std::cout << ( failures ? "FAILED" : "ok" ) << std::endl;
+  return failures ? 1 : 0;
+}